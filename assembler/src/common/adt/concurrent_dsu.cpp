@@ -14,7 +14,7 @@
 
 namespace dsu {
 
-size_t ConcurrentDSU::extract_to_file(const std::string &Prefix) {
+size_t ConcurrentDSU::extract(std::vector<size_t> &entries, std::vector<size_t> &offsets) {
     INFO("Connecting to root");
     // First, touch all the sets to make them directly connect to the root
 #   pragma omp parallel for
@@ -49,40 +49,48 @@ size_t ConcurrentDSU::extract_to_file(const std::string &Prefix) {
     }
 
     // Now we know the sizes of each cluster. Go over again and calculate the
-    // file-relative (cumulative) offsets.
+    // cumulative offsets.
+    offsets.clear();
+    offsets.reserve(sizes.size() + 1);
     size_t off = 0;
     for (size_t x = 0; x < data_.size(); ++x) {
         if (is_root(x)) {
             size_t &entry = sizes[x];
             size_t noff = off + entry;
+            offsets.push_back(off);
             entry = off;
             off = noff;
         }
     }
+    offsets.push_back(off);
 
     INFO("Writing down entries");
     // Write down the entries
-    std::vector<size_t> out(off);
+    entries.resize(off);
     for (size_t x = 0; x < data_.size(); ++x) {
         size_t &entry = sizes[parent(x)];
-        out[entry++] = x;
+        entries[entry++] = x;
     }
+
+    return sizes.size();
+}
+
+size_t ConcurrentDSU::extract_to_file(const std::string &Prefix) {
+    std::vector<size_t> entries, offsets;
+    size_t nsets = extract(entries, offsets);
+
     std::ofstream os(Prefix, std::ios::binary | std::ios::out);
-    os.write((char *) &out[0], out.size() * sizeof(out[0]));
+    os.write((char *) entries.data(), entries.size() * sizeof(entries[0]));
     os.close();
 
     // Write down the sizes
     MMappedRecordWriter <size_t> index(Prefix + ".idx");
-    index.reserve(sizes.size());
+    index.reserve(nsets);
     size_t *idx = index.data();
-    for (size_t x = 0, i = 0, sz = 0; x < data_.size(); ++x) {
-        if (is_root(x)) {
-            idx[i++] = sizes[x] - sz;
-            sz = sizes[x];
-        }
-    }
+    for (size_t i = 0; i < nsets; ++i)
+        idx[i] = offsets[i + 1] - offsets[i];
 
-    return sizes.size();
+    return nsets;
 }
 
 }
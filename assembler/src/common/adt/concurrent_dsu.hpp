@@ -198,6 +198,9 @@ public:
         }
     }
 
+    // Collects the sets into a flat array: elements of the i-th set are stored
+    // in entries[offsets[i]..offsets[i + 1]). Returns the number of sets.
+    size_t extract(std::vector<size_t> &entries, std::vector<size_t> &offsets);
     size_t extract_to_file(const std::string &Prefix);
 
     void get_sets(std::vector<std::vector<size_t> > &otherWay) {
@@ -64,6 +64,13 @@ public:
         return nucls_;
     }
 
+    // Replaces the storage of the nucleotides, the sequence itself must stay the same
+    void set_nucls(const Sequence &nucls) {
+        VERIFY(nucls.size() == nucls_.size());
+        VERIFY_DEV(nucls == nucls_);
+        nucls_ = nucls;
+    }
+
     void inc_raw_coverage(int value) {
         coverage_.inc_coverage(value);
     }
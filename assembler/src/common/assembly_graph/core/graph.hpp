@@ -10,6 +10,10 @@
 #include "observable_graph.hpp"
 #include "coverage.hpp"
 #include "debruijn_data.hpp"
+#include "sequence/nucl_arena.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <memory>
 
 namespace debruijn_graph {
 
@@ -28,6 +32,7 @@ public:
     typedef const VertexIterator const_iterator; // for for_each
 private:
     CoverageIndex<DeBruijnGraph> coverage_index_;
+    std::unique_ptr<NuclArena> sequence_arena_;
 
 public:
     DeBruijnGraph(size_t k) :
@@ -89,6 +94,46 @@ public:
         return Sequence();
     }
 
+    /**
+     * Edge sequences are compacted into slab arena owned by the graph instead
+     * of separate heap buffers per edge. Compaction is explicit, edges created
+     * after it are heap-backed until the next CompactSequences() call.
+     */
+    void EnableSequenceArena() {
+        if (!sequence_arena_)
+            sequence_arena_.reset(new NuclArena());
+    }
+
+    bool sequence_arena_enabled() const {
+        return bool(sequence_arena_);
+    }
+
+    /**
+     * Repacks all edge sequences into a fresh arena and drops the previous one.
+     * This also releases the buffers retained by the parts of split / deleted edges
+     * and the fragmentation left by merges. Slabs still referenced by sequences
+     * outside of the graph stay alive until they are released.
+     */
+    void CompactSequences() {
+        VERIFY(sequence_arena_enabled());
+        std::vector<EdgeId> edges(this->canonical_edges().begin(), this->canonical_edges().end());
+
+        std::unique_ptr<NuclArena> arena(new NuclArena());
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            EdgeId e = edges[i];
+            Sequence packed(EdgeNucls(e), *arena);
+            EdgeId ce = this->conjugate(e);
+            if (ce != e)
+                this->data(ce).set_nucls(!packed);
+            this->data(e).set_nucls(packed);
+        }
+
+        sequence_arena_ = std::move(arena);
+        INFO("Edge sequences compacted into " << sequence_arena_->slabs() << " slabs, "
+             << sequence_arena_->capacity() / (1024 * 1024) << " Mb");
+    }
+
 private:
     DECL_LOGGER("DeBruijnGraph")
 };
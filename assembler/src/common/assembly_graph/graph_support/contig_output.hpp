@@ -9,27 +9,31 @@
 
 #include "assembly_graph/core/graph.hpp"
 #include "io/reads/osequencestream.hpp"
+#include "io/utils/ordered_writer.hpp"
 
 namespace debruijn_graph {
 
 inline void OutputEdgeSequences(const Graph &g, const std::string &contigs_output_filename) {
     INFO("Outputting contigs to " << contigs_output_filename << ".fasta");
-    io::osequencestream_cov oss(contigs_output_filename + ".fasta");
-
-    for (EdgeId e: g.canonical_edges()) {
-        oss << g.coverage(e);
-        oss << g.EdgeNucls(e).str();
-    }
+    std::vector<EdgeId> edges(g.canonical_edges().begin(), g.canonical_edges().end());
+    std::ofstream os(contigs_output_filename + ".fasta");
+    io::WriteOrdered(os, edges.size(), [&](size_t i, std::ostream &buf) {
+        // Velvet format: NODE_1_length_24705_cov_358.255249
+        std::string s = g.EdgeNucls(edges[i]).str();
+        io::FastaWriter::Write(buf, io::MakeContigId(i + 1, s.size(), g.coverage(edges[i])), s);
+    });
 }
 
 inline void OutputEdgesByID(const Graph &g,
                             const std::string &contigs_output_filename) {
     INFO("Outputting contigs to " << contigs_output_filename << ".fasta");
-    io::OFastaReadStream oss(contigs_output_filename + ".fasta");
-    for (EdgeId e: g.canonical_edges()) {
+    std::vector<EdgeId> edges(g.canonical_edges().begin(), g.canonical_edges().end());
+    std::ofstream os(contigs_output_filename + ".fasta");
+    io::WriteOrdered(os, edges.size(), [&](size_t i, std::ostream &buf) {
+        EdgeId e = edges[i];
         std::string s = g.EdgeNucls(e).str();
-        oss << io::SingleRead(io::MakeContigId(g.int_id(e), s.size(), g.coverage(e), "EDGE"), s);
-    }
+        io::FastaWriter::Write(buf, io::MakeContigId(g.int_id(e), s.size(), g.coverage(e), "EDGE"), s);
+    });
 }
 } // namespace debruijn_graph
 
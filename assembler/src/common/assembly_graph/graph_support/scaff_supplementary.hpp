@@ -140,6 +140,15 @@ public:
         used_by_paths_[path_id].insert(g_.conjugate(e));
     }
 
+    //Marks the edge as used without attributing it to any path
+    void insert(EdgeId e) {
+        if (!unique_.IsUnique(e))
+            return;
+
+        used_.insert(e);
+        used_.insert(g_.conjugate(e));
+    }
+
     bool IsUsed(EdgeId e, size_t path_id) const {
         auto it = used_by_paths_.find(path_id);
         return it != used_by_paths_.end() && it->second.find(e) != it->second.end();
@@ -181,6 +190,8 @@ public:
 
 };
 
+class LongReadsUniqueEdgeAnalyzer;
+
 //FIXME rename
 struct UniqueData {
     size_t min_unique_length_;
@@ -192,6 +203,7 @@ struct UniqueData {
     ScaffoldingUniqueEdgeStorage unique_pb_storage_;
     std::vector<PathContainer> long_reads_paths_;
     std::vector<GraphCoverageMap> long_reads_cov_map_;
+    std::vector<std::shared_ptr<const LongReadsUniqueEdgeAnalyzer>> long_reads_unique_edges_;
 };
 
 } // namespace path_extend
@@ -11,9 +11,12 @@
 #include "io/binary/binary.hpp"
 #include "adt/small_pod_vector.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 #include <algorithm>
 #include <atomic>
 #include <deque>
+#include <memory>
 #include <vector>
 
 namespace path_extend {
@@ -378,8 +381,16 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
 
     const debruijn_graph::Graph& g_;
     BidirectionalPath* conj_path_;
-    // Length from beginning of i-th edge to path end: L(e_i + gap_(i+1) + e_(i+1) + ... + gap_N + e_N)
-    std::deque<size_t> cumulative_len_;
+    // Coordinate of the beginning of i-th edge on the path line. The origin is arbitrary
+    // (coordinates are never shifted on push / pop), so L(e_i + gap_(i+1) + ... + gap_N + e_N)
+    // is the coordinate of the end of e_N minus edge_start_[i].
+    std::deque<int64_t> edge_start_;
+    // Edge -> its positions in the path, built once the path gets long. Positions are
+    // stored shifted by index_base_ (the position of the front edge), so adding an edge
+    // to the front does not invalidate them.
+    typedef phmap::flat_hash_map<EdgeId, std::vector<int64_t>> EdgePositions;
+    std::unique_ptr<EdgePositions> edge_positions_;
+    int64_t index_base_;
     adt::SmallPODVector<PathListener*,
                         adt::impl::HybridAllocatedStorage<PathListener*, 2>> listeners_;
     const uint64_t id_;  //Unique ID
@@ -389,6 +400,7 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
     BidirectionalPath(const debruijn_graph::Graph& g)
             : g_(g),
               conj_path_(nullptr),
+              index_base_(0),
               id_(path_id_++),
               weight_(1.0),
               cycle_overlapping_(-1) {}
@@ -401,13 +413,15 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
     BidirectionalPath(const debruijn_graph::Graph& g, SimpleBidirectionalPath path)
             : BidirectionalPath(g)  {
         SimpleBidirectionalPath::PushBack(std::move(path));
-        cumulative_len_.resize(Size(), 0);
-
-        for (size_t i = 0; i < Size(); ++i)
-            cumulative_len_.front() += g_.length(edges_[i]) + gaps_[i].gap;
+        if (Empty())
+            return;
 
+        edge_start_.push_back(-gaps_[0].gap);
         for (size_t i = 1; i < Size(); ++i)
-            cumulative_len_[i] = cumulative_len_[i - 1] - g_.length(edges_[i - 1]) - gaps_[i].gap;
+            edge_start_.push_back(edge_start_.back() + (int64_t) g_.length(edges_[i - 1]) + gaps_[i].gap);
+
+        if (Size() >= EDGE_INDEX_THRESHOLD)
+            BuildEdgeIndex();
     }
 
     BidirectionalPath(const debruijn_graph::Graph& g, std::vector<EdgeId> path)
@@ -417,7 +431,9 @@ class BidirectionalPath : public PathListener, public SimpleBidirectionalPath {
             : SimpleBidirectionalPath(path),
               g_(path.g_),
               conj_path_(nullptr),
-              cumulative_len_(path.cumulative_len_),
+              edge_start_(path.edge_start_),
+              edge_positions_(path.edge_positions_ ? new EdgePositions(*path.edge_positions_) : nullptr),
+              index_base_(path.index_base_),
               listeners_(),
               id_(path_id_++),
               weight_(path.weight_),
@@ -556,7 +572,7 @@ public:
             return 0;
         }
         VERIFY(gaps_[0].gap == 0);
-        return cumulative_len_[0];
+        return LengthAt(0);
     }
 
     int ShiftLength(size_t index) const {
@@ -565,7 +581,53 @@ public:
 
     // Length from beginning of i-th edge to path end for forward directed path: L(e1 + e2 + ... + eN)
     size_t LengthAt(size_t index) const noexcept {
-        return cumulative_len_[index];
+        return size_t(EndCoord() - edge_start_[index]);
+    }
+
+    // The ones below shadow the linear scans of SimpleBidirectionalPath and use
+    // the edge index when it is available
+    using SimpleBidirectionalPath::FindFirst;
+    using SimpleBidirectionalPath::FindLast;
+
+    int FindFirst(EdgeId e) const noexcept {
+        if (!edge_positions_)
+            return SimpleBidirectionalPath::FindFirst(e);
+
+        auto it = edge_positions_->find(e);
+        if (it == edge_positions_->end())
+            return -1;
+        return static_cast<int>(it->second.front() - index_base_);
+    }
+
+    int FindLast(EdgeId e) const noexcept {
+        if (!edge_positions_)
+            return SimpleBidirectionalPath::FindLast(e);
+
+        auto it = edge_positions_->find(e);
+        if (it == edge_positions_->end())
+            return -1;
+        return static_cast<int>(it->second.back() - index_base_);
+    }
+
+    bool Contains(EdgeId e) const noexcept {
+        return FindFirst(e) != -1;
+    }
+
+    std::vector<size_t> FindAll(EdgeId e, size_t start = 0) const {
+        if (!edge_positions_)
+            return SimpleBidirectionalPath::FindAll(e, start);
+
+        VERIFY(start < Size());
+        std::vector<size_t> result;
+        auto it = edge_positions_->find(e);
+        if (it == edge_positions_->end())
+            return result;
+
+        const auto &positions = it->second;
+        for (auto pos = std::lower_bound(positions.begin(), positions.end(), index_base_ + (int64_t) start);
+             pos != positions.end(); ++pos)
+            result.push_back(size_t(*pos - index_base_));
+        return result;
     }
 
     size_t GetId() const noexcept {
@@ -582,8 +644,13 @@ public:
             VERIFY(e == edges_[cycle_overlapping_]);
             ++cycle_overlapping_;
         }
+        int64_t start = edge_start_.empty() ? 0 : EndCoord() + gap.gap;
         SimpleBidirectionalPath::PushBack(e, std::move(gap));
-        IncreaseLengths(g_.length(e), gaps_.back().gap);
+        edge_start_.push_back(start);
+        if (edge_positions_)
+            (*edge_positions_)[e].push_back(index_base_ + (int64_t) Size() - 1);
+        else if (Size() >= EDGE_INDEX_THRESHOLD)
+            BuildEdgeIndex();
         NotifyBackEdgeAdded(e, gaps_.back());
     }
 
@@ -608,7 +675,9 @@ public:
             return;
 
         EdgeId e = edges_.back();
-        DecreaseLengths();
+        if (edge_positions_)
+            RemoveIndexed(e, /*back*/ true);
+        edge_start_.pop_back();
         SimpleBidirectionalPath::PopBack();
         NotifyBackEdgeRemoved(e);
         DecreaseCycleOverlapping();
@@ -680,20 +749,34 @@ public:
 private:
     std::vector<std::string> PrintLines() const;
 
-    void IncreaseLengths(size_t length, int gap) {
-        for (auto iter = cumulative_len_.begin(); iter != cumulative_len_.end(); ++iter) {
-            *iter += length + gap;
-        }
-        cumulative_len_.push_back(length);
+    // Paths of this size and longer get the edge -> positions index
+    static const size_t EDGE_INDEX_THRESHOLD = 64;
+
+    int64_t EndCoord() const noexcept {
+        return edge_start_.back() + (int64_t) g_.length(edges_.back());
     }
 
-    void DecreaseLengths() {
-        size_t length = g_.length(edges_.back()) + gaps_.back().gap;
+    void BuildEdgeIndex() {
+        edge_positions_.reset(new EdgePositions());
+        index_base_ = 0;
+        for (size_t i = 0; i < Size(); ++i)
+            (*edge_positions_)[edges_[i]].push_back((int64_t) i);
+    }
 
-        for (auto iter = cumulative_len_.begin(); iter != cumulative_len_.end(); ++iter) {
-            *iter -= length;
-        }
-        cumulative_len_.pop_back();
+    void RemoveIndexed(EdgeId e, bool back) {
+        auto it = edge_positions_->find(e);
+        VERIFY(it != edge_positions_->end());
+        auto &positions = it->second;
+        if (back)
+            positions.pop_back();
+        else
+            positions.erase(positions.begin());
+        if (positions.empty())
+            edge_positions_->erase(it);
+
+        // Path became empty, start from scratch
+        if (edge_positions_->empty())
+            edge_positions_.reset();
     }
 
     void NotifyFrontEdgeAdded(EdgeId e, const Gap& gap) {
@@ -726,20 +809,25 @@ private:
             ++cycle_overlapping_;
         }
 
+        int64_t start = edge_start_.empty() ? 0 : edge_start_.front() - gap.gap - (int64_t) g_.length(e);
         SimpleBidirectionalPath::PushFront(e, gap);
-
-        int length = (int) g_.length(e);
-        if (cumulative_len_.empty()) {
-            cumulative_len_.push_front(length);
-        } else {
-            cumulative_len_.push_front(cumulative_len_.front() + length + gap.gap);
+        edge_start_.push_front(start);
+        if (edge_positions_) {
+            auto &positions = (*edge_positions_)[e];
+            positions.insert(positions.begin(), --index_base_);
+        } else if (Size() >= EDGE_INDEX_THRESHOLD) {
+            BuildEdgeIndex();
         }
         NotifyFrontEdgeAdded(e, gap);
     }
 
     void PopFront() {
         EdgeId e = edges_.front();
-        cumulative_len_.pop_front();
+        if (edge_positions_) {
+            RemoveIndexed(e, /*back*/ false);
+            ++index_base_;
+        }
+        edge_start_.pop_front();
         SimpleBidirectionalPath::PopFront();
 
         NotifyFrontEdgeRemoved(e);
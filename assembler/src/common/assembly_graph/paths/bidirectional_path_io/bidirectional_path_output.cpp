@@ -13,16 +13,24 @@ void path_extend::ContigWriter::OutputPaths(const PathContainer &paths, const st
 
     ScaffoldSequenceMaker scaffold_maker(g_);
     DEBUG("started" << paths.size());
+    std::vector<const BidirectionalPath*> to_output;
     for (auto iter = paths.begin(); iter != paths.end(); ++iter) {
         const BidirectionalPath &path = iter.get();
         DEBUG("path: " <<  path.Length());
         if (path.Length() <= 0)
             continue;
-        auto path_string = scaffold_maker.MakeSequence(path);
-        if (path_string.length() >= g_.k()) {
-            storage.emplace_back(path_string, &path);
-        }
-        DEBUG("over");
+        to_output.push_back(&path);
+    }
+
+    // Sequence construction is independent for every path, only naming below is stateful
+    std::vector<std::string> path_strings(to_output.size());
+#   pragma omp parallel for schedule(dynamic, 16)
+    for (size_t i = 0; i < to_output.size(); ++i)
+        path_strings[i] = scaffold_maker.MakeSequence(*to_output[i]);
+
+    for (size_t i = 0; i < to_output.size(); ++i) {
+        if (path_strings[i].length() >= g_.k())
+            storage.emplace_back(std::move(path_strings[i]), to_output[i]);
     }
     DEBUG("sort");
     //sorting by length and coverage
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "io/utils/edge_namer.hpp"
+#include "io/utils/ordered_writer.hpp"
 #include "io/graph/gfa_writer.hpp"
 #include "io/graph/fastg_writer.hpp"
 #include "io_support.hpp"
@@ -54,12 +55,13 @@ public:
 
     void WritePaths(const ScaffoldStorage &scaffold_storage, const std::string &fn) const {
         std::ofstream os(fn);
-        for (const auto& scaffold_info : scaffold_storage) {
-            os << scaffold_info.name << "\n"
-               << path_writer_.ToPathString(*scaffold_info.path) << "\n"
-               << scaffold_info.name << "'" << "\n"
-               << path_writer_.ToPathString(*scaffold_info.path->GetConjPath()) << "\n";
-        }
+        io::WriteOrdered(os, scaffold_storage.size(), [&](size_t i, std::ostream &buf) {
+            const auto &scaffold_info = scaffold_storage[i];
+            buf << scaffold_info.name << "\n"
+                << path_writer_.ToPathString(*scaffold_info.path) << "\n"
+                << scaffold_info.name << "'" << "\n"
+                << path_writer_.ToPathString(*scaffold_info.path->GetConjPath()) << "\n";
+        });
     }
 
   private:
@@ -68,20 +70,48 @@ public:
 
 
 class GFAPathWriter : public gfa::GFAWriter {
-    void WritePath(const std::string &name, size_t segment_id,
-                   const std::vector<std::string> &edge_strs,
-                   const std::string &flags) {
-        os_ << "P" << "\t" ;
-        os_ << name << "_" << segment_id << "\t";
+    static void WritePath(std::ostream &os,
+                          const std::string &name, size_t segment_id,
+                          const std::vector<std::string> &edge_strs,
+                          const std::string &flags) {
+        os << "P" << "\t" ;
+        os << name << "_" << segment_id << "\t";
         std::string delimeter = "";
         for (const auto& e : edge_strs) {
-            os_ << delimeter << e;
+            os << delimeter << e;
             delimeter = ",";
         }
-        os_ << "\t*";
+        os << "\t*";
         if (flags.length())
-            os_ << "\t" << flags;
-        os_ << "\n";
+            os << "\t" << flags;
+        os << "\n";
+    }
+
+    void WritePath(const std::string &name, size_t segment_id,
+                   const std::vector<std::string> &edge_strs,
+                   const std::string &flags) {
+        WritePath(os_, name, segment_id, edge_strs, flags);
+    }
+
+    void WriteScaffoldPath(std::ostream &os, const ScaffoldInfo &scaffold_info) const {
+        const path_extend::BidirectionalPath &p = *scaffold_info.path;
+        if (p.Size() == 0)
+            return;
+
+        std::vector<std::string> segmented_path;
+        size_t segment_id = 1;
+        for (size_t i = 0; i < p.Size() - 1; ++i) {
+            EdgeId e = p[i];
+            segmented_path.push_back(edge_namer_.EdgeOrientationString(e));
+            if (graph_.EdgeEnd(e) != graph_.EdgeStart(p[i+1]) || p.GapAt(i+1).gap > 0) {
+                WritePath(os, scaffold_info.name, segment_id, segmented_path, "");
+                segment_id++;
+                segmented_path.clear();
+            }
+        }
+
+        segmented_path.push_back(edge_namer_.EdgeOrientationString(p.Back()));
+        WritePath(os, scaffold_info.name, segment_id, segmented_path, "");
     }
 
 public:
@@ -107,27 +137,9 @@ public:
     }
 
     void WritePaths(const ScaffoldStorage &scaffold_storage) {
-        for (const auto& scaffold_info : scaffold_storage) {
-            const path_extend::BidirectionalPath &p = *scaffold_info.path;
-            if (p.Size() == 0) {
-                continue;
-            }
-            std::vector<std::string> segmented_path;
-            //size_t id = p.GetId();
-            size_t segment_id = 1;
-            for (size_t i = 0; i < p.Size() - 1; ++i) {
-                EdgeId e = p[i];
-                segmented_path.push_back(edge_namer_.EdgeOrientationString(e));
-                if (graph_.EdgeEnd(e) != graph_.EdgeStart(p[i+1]) || p.GapAt(i+1).gap > 0) {
-                    WritePath(scaffold_info.name, segment_id, segmented_path, "");
-                    segment_id++;
-                    segmented_path.clear();
-                }
-            }
-
-            segmented_path.push_back(edge_namer_.EdgeOrientationString(p.Back()));
-            WritePath(scaffold_info.name, segment_id, segmented_path, "");
-        }
+        io::WriteOrdered(os_, scaffold_storage.size(), [&](size_t i, std::ostream &buf) {
+            WriteScaffoldPath(buf, scaffold_storage[i]);
+        });
     }
 };
 
@@ -139,13 +151,12 @@ class ContigWriter {
 
 public:
     static void WriteScaffolds(const ScaffoldStorage &scaffold_storage, const std::string &fn) {
-        io::OFastaReadStream oss(fn);
-        std::ofstream os_fastg;
-
-        for (const auto& scaffold_info : scaffold_storage) {
+        std::ofstream os(fn);
+        io::WriteOrdered(os, scaffold_storage.size(), [&](size_t i, std::ostream &buf) {
+            const auto &scaffold_info = scaffold_storage[i];
             TRACE("Scaffold " << scaffold_info.name << " originates from path " << scaffold_info.path->str());
-            oss << io::SingleRead(scaffold_info.name, scaffold_info.sequence);
-        }
+            io::FastaWriter::Write(buf, scaffold_info.name, scaffold_info.sequence);
+        });
     }
 
     static PathsWriterT BasicFastaWriter(const std::string &fn) {
@@ -9,7 +9,9 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/core/graph_iterators.hpp"
 #include "common/io/reads/osequencestream.hpp"
+#include "common/io/utils/ordered_writer.hpp"
 
+#include <fstream>
 #include <set>
 #include <string>
 #include <sstream>
@@ -33,15 +35,19 @@ static std::string FormHeader(const std::string &id,
 }
 
 void FastgWriter::WriteSegmentsAndLinks() {
-    io::OFastaReadStream os(fn_);
-    for (auto it = graph_.ConstEdgeBegin(); !it.IsEnd(); ++it) {
-        EdgeId e = *it;
+    std::vector<EdgeId> edges;
+    for (auto it = graph_.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        edges.push_back(*it);
+
+    std::ofstream os(fn_);
+    io::WriteOrdered(os, edges.size(), [&](size_t i, std::ostream &buf) {
+        EdgeId e = edges[i];
         std::set<std::string> next;
         for (EdgeId next_e : graph_.OutgoingEdges(graph_.EdgeEnd(e))) {
             next.insert(extended_namer_.EdgeOrientationString(next_e));
         }
-        os << io::SingleRead(FormHeader(extended_namer_.EdgeOrientationString(e), next),
-                             graph_.EdgeNucls(e).str());
-    }
+        io::FastaWriter::Write(buf, FormHeader(extended_namer_.EdgeOrientationString(e), next),
+                               graph_.EdgeNucls(e).str());
+    });
 }
 
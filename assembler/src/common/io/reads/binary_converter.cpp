@@ -14,6 +14,7 @@
 #include "pipeline/library.hpp"
 #include "utils/logger/logger.hpp"
 #include "utils/verify.hpp"
+#include "utils/perf/resource_usage.hpp"
 
 #include "threadpool/threadpool.hpp"
 
@@ -109,6 +110,7 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     read_stats.write(*file_ds_);
 
     INFO(read_count << " reads written");
+    utils::count_items("converted_reads", read_count);
     return read_stats;
 }
 
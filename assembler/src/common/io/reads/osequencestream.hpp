@@ -13,6 +13,7 @@
 #include "header_naming.hpp"
 #include "common/pipeline/library_fwd.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -20,10 +21,9 @@
 namespace io {
 
 inline void WriteWrapped(const std::string &s, std::ostream &os, size_t max_width = 60) {
-    size_t cur = 0;
-    while (cur < s.size()) {
-        os << s.substr(cur, max_width) << "\n";
-        cur += max_width;
+    for (size_t cur = 0; cur < s.size(); cur += max_width) {
+        os.write(s.data() + cur, (std::streamsize)std::min(max_width, s.size() - cur));
+        os << '\n';
     }
 }
 
@@ -109,9 +109,13 @@ public:
 };
 
 struct FastaWriter {
+    static void Write(std::ostream &stream, const std::string &name, const std::string &seq) {
+        stream << ">" << name << "\n";
+        WriteWrapped(seq, stream);
+    }
+
     static void Write(std::ostream &stream, const SingleRead &read) {
-        stream << ">" << read.name() << "\n";
-        WriteWrapped(read.GetSequenceString(), stream);
+        Write(stream, read.name(), read.GetSequenceString());
     }
 };
 
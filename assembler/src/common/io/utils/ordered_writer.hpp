@@ -0,0 +1,56 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace io {
+
+/**
+ * Formats count records in parallel and writes them to os in their original
+ * order. format(i, os) must print the i-th record into the given stream and
+ * must be safe to call concurrently. Records are processed in chunks, each
+ * chunk is split into contiguous blocks formatted into separate buffers,
+ * which are then flushed with a single write each. So the output is byte
+ * identical to the serial one, while the memory overhead is bounded by the
+ * text of a single chunk.
+ */
+template<class Format>
+void WriteOrdered(std::ostream &os, size_t count, const Format &format,
+                  size_t chunk_size = 4096) {
+    size_t nblocks = 4 * (size_t)omp_get_max_threads();
+    std::vector<std::ostringstream> buffers(nblocks);
+
+    for (size_t chunk_start = 0; chunk_start < count; chunk_start += chunk_size) {
+        size_t chunk_end = std::min(count, chunk_start + chunk_size);
+        size_t block_size = (chunk_end - chunk_start + nblocks - 1) / nblocks;
+
+#       pragma omp parallel for schedule(dynamic, 1)
+        for (size_t b = 0; b < nblocks; ++b) {
+            std::ostringstream &buf = buffers[b];
+            buf.str("");
+            buf.clear();
+            size_t start = std::min(chunk_end, chunk_start + b * block_size);
+            size_t end = std::min(chunk_end, start + block_size);
+            for (size_t i = start; i < end; ++i)
+                format(i, buf);
+        }
+
+        for (const auto &buf : buffers) {
+            const std::string s = buf.str();
+            os.write(s.data(), s.size());
+        }
+    }
+}
+
+}
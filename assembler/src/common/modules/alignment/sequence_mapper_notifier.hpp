@@ -16,6 +16,7 @@
 #include "io/reads/read_stream_vector.hpp"
 
 #include "utils/perf/timetracer.hpp"
+#include "utils/perf/resource_usage.hpp"
 
 #include <string>
 #include <vector>
@@ -93,6 +94,7 @@ public:
             NotifyMergeBuffer(lib_index, i);
 
         INFO("Total " << counter << " reads processed");
+        utils::count_items("mapped_reads", counter);
         NotifyStopProcessLibrary(lib_index);
     }
 
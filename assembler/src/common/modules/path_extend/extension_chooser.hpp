@@ -401,12 +401,19 @@ class ExcludingExtensionChooser: public ExtensionChooser {
     PathAnalyzer analyzer_;
     double prior_coeff_;
 
-    AlternativeContainer FindWeights(const BidirectionalPath& path, const EdgeContainer& edges, const std::set<size_t>& to_exclude) const {
+    AlternativeContainer FindWeights(const BidirectionalPath& path, const EdgeContainer& edges,
+                                     const std::set<size_t>& to_exclude, PairedInfoCache& cache) const {
+        std::vector<EdgeId> candidates;
+        candidates.reserve(edges.size());
+        for (const auto &e_d : edges)
+            candidates.push_back(e_d.e_);
+
+        std::vector<double> candidate_weights = wc_->CountWeights(path, candidates, cache, to_exclude);
         AlternativeContainer weights;
-        for (auto iter = edges.begin(); iter != edges.end(); ++iter) {
-            double weight = wc_->CountWeight(path, iter->e_, to_exclude);
-            weights.emplace(weight, *iter);
-            DEBUG("Candidate " << g_.int_id(iter->e_) << " weight " << weight << " length " << g_.length(iter->e_));
+        for (size_t i = 0; i < edges.size(); ++i) {
+            double weight = candidate_weights[i];
+            weights.emplace(weight, edges[i]);
+            DEBUG("Candidate " << g_.int_id(edges[i].e_) << " weight " << weight << " length " << g_.length(edges[i].e_));
         }
         NotifyAll(weights);
         return weights;
@@ -423,8 +430,8 @@ class ExcludingExtensionChooser: public ExtensionChooser {
     }
 
     EdgeContainer FindFilteredEdges(const BidirectionalPath& path,
-            const EdgeContainer& edges, const std::set<size_t>& to_exclude) const {
-        AlternativeContainer weights = FindWeights(path, edges, to_exclude);
+            const EdgeContainer& edges, const std::set<size_t>& to_exclude, PairedInfoCache& cache) const {
+        AlternativeContainer weights = FindWeights(path, edges, to_exclude, cache);
         VERIFY(!weights.empty());
         auto max_weight = (--weights.end())->first;
         EdgeContainer top = FindPossibleEdges(weights, max_weight);
@@ -440,7 +447,8 @@ protected:
 
     virtual void ExcludeEdges(const BidirectionalPath& path,
                               const EdgeContainer& /*edges*/,
-                              std::set<size_t>& to_exclude) const {
+                              std::set<size_t>& to_exclude,
+                              PairedInfoCache& /*cache*/) const {
         analyzer_.RemoveTrivial(path, to_exclude);
     }
 
@@ -461,9 +469,11 @@ public:
         std::set<size_t> to_exclude;
         path.PrintDEBUG();
         EdgeContainer result = edges;
-        ExcludeEdges(path, result, to_exclude);
+        //Paired info fetched while excluding edges is reused for weighting the candidates
+        PairedInfoCache cache;
+        ExcludeEdges(path, result, to_exclude, cache);
         DEBUG("Excluded " << to_exclude.size() << " edges")
-        result = FindFilteredEdges(path, result, to_exclude);
+        result = FindFilteredEdges(path, result, to_exclude, cache);
         if (result.size() == 1) {
             DEBUG("Paired-end extension chooser helped");
         }
@@ -477,8 +487,9 @@ private:
 
 class SimpleExtensionChooser: public ExcludingExtensionChooser {
 protected:
-    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude) const override {
-        ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
+    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude,
+                      PairedInfoCache& cache) const override {
+        ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude, cache);
 
         if (edges.size() < 2) {
             return;
@@ -507,7 +518,7 @@ protected:
         //excluding based on presense of ambiguous paired info
         std::map<size_t, unsigned> edge_2_extension_cnt;
         for (size_t i = 0; i < edges.size(); ++i) {
-            for (size_t e : wc_->PairInfoExist(path, edges.at(i).e_)) {
+            for (size_t e : wc_->PairInfoExist(path, edges.at(i).e_, 0, &cache)) {
                 edge_2_extension_cnt[e] += 1;
             }
         }
@@ -534,7 +545,7 @@ private:
 class IdealBasedExtensionChooser : public ExcludingExtensionChooser {
 protected:
     void ExcludeEdges(const BidirectionalPath &path, const EdgeContainer &edges,
-                      std::set<size_t> &to_exclude) const override {
+                      std::set<size_t> &to_exclude, PairedInfoCache &/*cache*/) const override {
         //commented for a reason
         //ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
         //if (edges.size() < 2) {
@@ -570,8 +581,9 @@ private:
 
 class RNAExtensionChooser: public ExcludingExtensionChooser {
 protected:
-    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude) const override {
-        ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
+    void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude,
+                      PairedInfoCache& cache) const override {
+        ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude, cache);
         if (edges.size() < 2) {
             return;
         }
@@ -600,8 +612,9 @@ private:
 
 class LongEdgeExtensionChooser: public ExcludingExtensionChooser {
 protected:
-    virtual void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude) const {
-        ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude);
+    virtual void ExcludeEdges(const BidirectionalPath& path, const EdgeContainer& edges, std::set<size_t>& to_exclude,
+                              PairedInfoCache& cache) const {
+        ExcludingExtensionChooser::ExcludeEdges(path, edges, to_exclude, cache);
         if (edges.size() < 2) {
             return;
         }
@@ -778,6 +791,8 @@ inline bool EdgeWithWeightCompareReverse(const std::pair<T, double>& p1,
     return p1.second > p2.second;
 }
 
+// Immutable once constructed, so one instance per library is built before
+// extension and shared by the choosers of all extender sets.
 class LongReadsUniqueEdgeAnalyzer {
     DECL_LOGGER("LongReadsUniqueEdgeAnalyzer")
 public:
@@ -1067,19 +1082,16 @@ public:
                               const GraphCoverageMap& read_paths_cov_map,
                               double filtering_threshold,
                               double weight_priority_threshold,
-                              double unique_edge_priority_threshold,
                               size_t min_significant_overlap,
-                              size_t max_repeat_length,
-                              bool uneven_depth)
+                              std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer)
             : ExtensionChooser(g),
               filtering_threshold_(filtering_threshold),
               weight_priority_threshold_(weight_priority_threshold),
               min_significant_overlap_(min_significant_overlap),
               cov_map_(read_paths_cov_map),
-              unique_edge_analyzer_(g, cov_map_, filtering_threshold,
-                                    unique_edge_priority_threshold,
-                                    max_repeat_length, uneven_depth)
+              unique_edge_analyzer_(std::move(unique_edge_analyzer))
     {
+        VERIFY(unique_edge_analyzer_);
     }
 
     /* Choose extension as correct only if we have reads that traverse a unique edge from the path and this extension.
@@ -1153,7 +1165,7 @@ private:
     bool UniqueBackPath(const BidirectionalPath& path, size_t pos) const {
         int int_pos = (int) pos;
         while (int_pos >= 0) {
-            if (unique_edge_analyzer_.IsUnique(path.At(int_pos)) > 0 && g_.length(path.At(int_pos)) >= min_significant_overlap_)
+            if (unique_edge_analyzer_->IsUnique(path.At(int_pos)) > 0 && g_.length(path.At(int_pos)) >= min_significant_overlap_)
                 return true;
             int_pos--;
         }
@@ -1170,7 +1182,7 @@ private:
     double weight_priority_threshold_;
     size_t min_significant_overlap_;
     const GraphCoverageMap& cov_map_;
-    LongReadsUniqueEdgeAnalyzer unique_edge_analyzer_;
+    std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer_;
 
     DECL_LOGGER("LongReadsExtensionChooser");
 };
@@ -1181,21 +1193,19 @@ public:
                                     const GraphCoverageMap& read_paths_cov_map,
                                     double filtering_threshold,
                                     double weight_priority_threshold,
-                                    double unique_edge_priority_threshold,
                                     size_t min_significant_overlap,
-                                    size_t max_repeat_length,
-                                    bool uneven_depth,
+                                    std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer,
                                     bool use_low_quality_matching = false)
             : ExtensionChooser(g)
             , filtering_threshold_(filtering_threshold)
             , weight_priority_threshold_(weight_priority_threshold)
             , min_significant_overlap_(min_significant_overlap)
             , cov_map_(read_paths_cov_map)
-            , unique_edge_analyzer_(g, cov_map_, filtering_threshold,
-                                    unique_edge_priority_threshold,
-                                    max_repeat_length, uneven_depth)
+            , unique_edge_analyzer_(std::move(unique_edge_analyzer))
             , use_low_quality_matching_(use_low_quality_matching)
-    {}
+    {
+        VERIFY(unique_edge_analyzer_);
+    }
 
     /// @returns the possible next edge of the path
     EdgeContainer Filter(const BidirectionalPath &path, const EdgeContainer &) const override {
@@ -1313,7 +1323,7 @@ private:
     }
 
     bool IsUniqueEdge(EdgeId edge) const {
-        return unique_edge_analyzer_.IsUnique(edge) && g_.length(edge) >= min_significant_overlap_;
+        return unique_edge_analyzer_->IsUnique(edge) && g_.length(edge) >= min_significant_overlap_;
     }
 
     bool HasUniqueEdge(const BidirectionalPath& path, size_t from, size_t len) const {
@@ -1335,7 +1345,7 @@ private:
     double weight_priority_threshold_;
     size_t min_significant_overlap_;
     const GraphCoverageMap& cov_map_;
-    LongReadsUniqueEdgeAnalyzer unique_edge_analyzer_;
+    std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer_;
     bool use_low_quality_matching_;
 
     DECL_LOGGER("TrustedContigsExtensionChooser");
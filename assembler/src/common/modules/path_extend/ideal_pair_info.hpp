@@ -9,7 +9,10 @@
 
 #include "assembly_graph/core/graph.hpp"
 #include "adt/flat_map.hpp"
-#include <parallel_hashmap/phmap.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
 #include <utility>
 #include <vector>
 
@@ -37,17 +40,18 @@ public:
             insert_size_distrib_[it->first] = double(it->second) / double(sum);
 
         PreCalculateNotTotalReadsWeight();
+        PreCalculateInsertSizeSums();
     }
 
+    // Thread-safe, the counter is immutable after construction
     double IdealPairedInfo(EdgeId e1, EdgeId e2, int dist, bool additive = false) const {
-        auto &weights = pi_[std::make_pair(g_.length(e1), g_.length(e2))];
-        auto entry = weights.insert(std::make_pair(dist, 0.));
-        if (entry.second)
-            entry.first->second = IdealPairedInfo(g_.length(e1), g_.length(e2), dist, additive);
-        return entry.first->second;
+        return IdealPairedInfo(g_.length(e1), g_.length(e2), dist, additive);
     }
 
     double IdealPairedInfo(size_t len1, size_t len2, int dist, bool additive = false) const {
+        if (!additive)
+            return IdealPairedInfoClosed(len1, len2, dist);
+
         double result = 0.0;
         for (const auto &entry : insert_size_distrib_) {
             if (entry.second > 0)
@@ -57,6 +61,72 @@ public:
     }
 
 private:
+    // Non-additive IdealReads() is a piecewise linear function of the insert size
+    // with at most three pieces, so its expectation over the insert size distribution
+    // is computed in O(1) from the prefix sums of P(is) and P(is) * is.
+    double IdealPairedInfoClosed(size_t len1_1, size_t len2_1, int dist) const {
+        int64_t len1 = (int64_t) len1_1;
+        int64_t len2 = (int64_t) len2_1;
+        int64_t k = (int64_t) k_;
+        int64_t rs = (int64_t) read_size_;
+        if (dist == 0)
+            return ExpectedLinear(is_min_, is_max_, -1, len1 + 2 * rs - 1 - k);
+
+        if (dist < 0) {
+            std::swap(len1, len2);
+            dist = -dist;
+        }
+
+        // IdealReads() = max(min(is + a, b) - max(c, is + d) + 1, 0)
+        int64_t gap_len = dist - len1;
+        int64_t a = -rs - 1, b = gap_len + len2 - 1;
+        int64_t c = gap_len + k + 1 - rs, d = k + 1 - 2 * rs - len1;
+        // is <= t1 <=> is + a <= b; is <= t2 <=> c >= is + d
+        int64_t t1 = b - a, t2 = c - d;
+        int64_t lo = std::min(t1, t2), hi = std::max(t1, t2);
+
+        double result = ExpectedLinear(c - a, lo, 1, a - c + 1) +
+                        ExpectedLinear(hi + 1, b - d, -1, b - d + 1);
+        int64_t middle = (t1 <= t2 ? b - c : a - d) + 1;
+        if (middle > 0)
+            result += ExpectedLinear(lo + 1, hi, 0, middle);
+
+        return result;
+    }
+
+    // Sum of P(is) * (slope * is + shift) over is in [from, to]
+    double ExpectedLinear(int64_t from, int64_t to, int64_t slope, int64_t shift) const {
+        from = std::max(from, is_min_);
+        to = std::min(to, is_max_);
+        if (from > to)
+            return 0.0;
+
+        size_t l = size_t(from - is_min_), r = size_t(to - is_min_ + 1);
+        return double(slope) * (prob_is_prefix_[r] - prob_is_prefix_[l]) +
+               double(shift) * (prob_prefix_[r] - prob_prefix_[l]);
+    }
+
+    void PreCalculateInsertSizeSums() {
+        if (insert_size_distrib_.empty()) {
+            is_min_ = 0, is_max_ = -1;
+            prob_prefix_.assign(1, 0.0);
+            prob_is_prefix_.assign(1, 0.0);
+            return;
+        }
+
+        is_min_ = insert_size_distrib_.begin()->first;
+        is_max_ = insert_size_distrib_.rbegin()->first;
+        std::vector<double> prob(size_t(is_max_ - is_min_ + 1), 0.0);
+        for (const auto &entry : insert_size_distrib_)
+            prob[size_t(entry.first - is_min_)] = entry.second;
+
+        prob_prefix_.assign(prob.size() + 1, 0.0);
+        prob_is_prefix_.assign(prob.size() + 1, 0.0);
+        for (size_t i = 0; i < prob.size(); ++i) {
+            prob_prefix_[i + 1] = prob_prefix_[i] + prob[i];
+            prob_is_prefix_[i + 1] = prob_is_prefix_[i] + prob[i] * double(is_min_ + (int64_t) i);
+        }
+    }
 
     double IdealReads(size_t len1_1, size_t len2_1, int dist,
                       size_t is_1, bool additive) const {
@@ -115,15 +185,11 @@ private:
     std::vector<double> not_total_weights_right_;
     std::vector<double> not_total_weights_left_;
 
-    struct PairHash {
-        size_t operator()(std::pair<size_t, size_t> pair) const {
-            return phmap::HashState().combine(0, pair.first, pair.second);
-        }
-    };
-
-    mutable phmap::parallel_node_hash_map<std::pair<size_t, size_t>,
-                                          phmap::flat_hash_map<int, double>,
-                                          PairHash> pi_;
+    // Dense prefix sums of P(is) and P(is) * is over [is_min_, is_max_]
+    int64_t is_min_;
+    int64_t is_max_;
+    std::vector<double> prob_prefix_;
+    std::vector<double> prob_is_prefix_;
 protected:
     DECL_LOGGER("PathExtendPI");
 };
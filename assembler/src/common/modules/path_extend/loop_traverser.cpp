@@ -8,6 +8,7 @@
 #include "pe_utils.hpp"
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/components/splitters.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 namespace path_extend {
 
@@ -91,10 +92,16 @@ bool LoopTraverser::IsEndInsideComponent(const BidirectionalPath &path, EdgeId c
     return IsEndInsideComponent(path.SubPath((size_t) i + 1), component_set);
 }
 
-bool LoopTraverser::TraverseLoop(EdgeId start, EdgeId end, const std::set<VertexId> &component_set) {
+bool LoopTraverser::PlanTraversal(LoopCandidate &candidate) const {
+    EdgeId start = candidate.start, end = candidate.finish;
+    const std::set<VertexId> &component_set = candidate.component_set;
+    candidate.traversable = false;
+
     DEBUG("start " << g_.int_id(start) << " end " << g_.int_id(end));
-    BidirectionalPathSet start_cover_paths = cov_map_.GetCoveringPaths(start);
-    BidirectionalPathSet end_cover_paths = cov_map_.GetCoveringPaths(end);
+    candidate.start_cover_paths = cov_map_.GetCoveringPaths(start);
+    candidate.end_cover_paths = cov_map_.GetCoveringPaths(end);
+    const BidirectionalPathSet &start_cover_paths = candidate.start_cover_paths;
+    const BidirectionalPathSet &end_cover_paths = candidate.end_cover_paths;
 
     for (auto path_ptr : start_cover_paths)
         if (path_ptr->FindAll(end).size() > 0)
@@ -147,7 +154,20 @@ bool LoopTraverser::TraverseLoop(EdgeId start, EdgeId end, const std::set<Vertex
             }
         }
     }
-    start_path.PushBack(end_path.SubPath(common_size), Gap(int(g_.k() + BASIC_N_CNT)));
+
+    candidate.start_path = &start_path;
+    candidate.end_path = &end_path;
+    candidate.common_size = common_size;
+    candidate.traversable = true;
+    return true;
+}
+
+void LoopTraverser::ApplyTraversal(const LoopCandidate &candidate) {
+    VERIFY(candidate.traversable);
+    BidirectionalPath& start_path = *candidate.start_path;
+    BidirectionalPath& end_path = *candidate.end_path;
+
+    start_path.PushBack(end_path.SubPath(candidate.common_size), Gap(int(g_.k() + BASIC_N_CNT)));
 
     DEBUG("travers");
     start_path.PrintDEBUG();
@@ -155,7 +175,25 @@ bool LoopTraverser::TraverseLoop(EdgeId start, EdgeId end, const std::set<Vertex
     DEBUG("conj");
     end_path.GetConjPath()->PrintDEBUG();
     end_path.Clear();
-    return true;
+}
+
+//Planning reads only the coverage of the entrance and exit edges and the paths covering them,
+//so it stays valid unless an earlier traversal has touched any of those
+bool LoopTraverser::IsStale(const LoopCandidate &candidate,
+                            const std::set<EdgeId> &changed_edges,
+                            const std::set<const BidirectionalPath*> &changed_paths) const {
+    for (EdgeId e : {candidate.start, candidate.finish}) {
+        if (changed_edges.count(e) || changed_edges.count(g_.conjugate(e)))
+            return true;
+    }
+
+    for (const auto *paths : {&candidate.start_cover_paths, &candidate.end_cover_paths}) {
+        for (const BidirectionalPath *path : *paths) {
+            if (changed_paths.count(path))
+                return true;
+        }
+    }
+    return false;
 }
 
 bool LoopTraverser::ContainsLongEdges(const omnigraph::GraphComponent<Graph>& component) const {
@@ -186,25 +224,63 @@ size_t LoopTraverser::CommonEndSize(const SimpleBidirectionalPath& start_path, c
 
 size_t LoopTraverser::TraverseAllLoops() {
     DEBUG("TraverseAllLoops");
-    size_t traversed = 0;
+    std::vector<omnigraph::GraphComponent<Graph>> components;
     auto splitter = omnigraph::LongEdgesExclusiveSplitter<Graph>(g_, long_edge_limit_);
     while (splitter->HasNext()) {
         omnigraph::GraphComponent<Graph> component = splitter->Next();
         if (component.v_size() > component_size_limit_)
             continue;
+        components.push_back(std::move(component));
+    }
+
+    //Candidates are checked and planned in parallel against the initial path state
+    std::vector<LoopCandidate> candidates(components.size());
+#   pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < components.size(); ++i) {
+        const auto &component = components[i];
         if (ContainsLongEdges(component))
             continue;
         if (AnyTipsInComponent(component))
             continue;
 
-        std::set<VertexId> component_set(component.v_begin(), component.v_end());
-        EdgeId start = FindStart(component_set);
-        EdgeId finish = FindFinish(component_set);
-        if (start == EdgeId() || finish == EdgeId())
+        LoopCandidate &candidate = candidates[i];
+        candidate.component_set.insert(component.v_begin(), component.v_end());
+        candidate.start = FindStart(candidate.component_set);
+        candidate.finish = FindFinish(candidate.component_set);
+        if (candidate.start == EdgeId() || candidate.finish == EdgeId())
+            continue;
+
+        PlanTraversal(candidate);
+    }
+    DEBUG("Planned " << candidates.size() << " loop traversals");
+
+    //Traversals are applied in the splitter order. Whenever an earlier traversal
+    //has invalidated a plan, it is recomputed, so the result matches a serial run
+    size_t traversed = 0;
+    std::set<EdgeId> changed_edges;
+    std::set<const BidirectionalPath*> changed_paths;
+    for (auto &candidate : candidates) {
+        if (candidate.start == EdgeId() || candidate.finish == EdgeId())
+            continue;
+
+        if (IsStale(candidate, changed_edges, changed_paths)) {
+            DEBUG("Replanning traversal of loop at " << g_.int_id(candidate.start));
+            PlanTraversal(candidate);
+        }
+        if (!candidate.traversable)
             continue;
 
-        if (TraverseLoop(start, finish, component_set))
-            ++traversed;
+        for (EdgeId e : *candidate.end_path) {
+            changed_edges.insert(e);
+            changed_edges.insert(g_.conjugate(e));
+        }
+        for (const BidirectionalPath *path : {candidate.start_path, candidate.end_path}) {
+            changed_paths.insert(path);
+            changed_paths.insert(path->GetConjPath());
+        }
+
+        ApplyTraversal(candidate);
+        ++traversed;
     }
     return traversed;
 }
@@ -9,6 +9,7 @@
 #define LOOP_TRAVERSER_H_
 
 #include "assembly_graph/paths/bidirectional_path.hpp"
+#include "assembly_graph/paths/bidirectional_path_container.hpp"
 #include "assembly_graph/components/graph_component.hpp"
 #include "assembly_graph/core/graph.hpp"
 #include <set>
@@ -36,7 +37,26 @@ class LoopTraverser {
     bool IsEndInsideComponent(const std::vector<EdgeId> &path, const std::set<VertexId> &component_set) const;
     bool IsEndInsideComponent(const BidirectionalPath &path, EdgeId component_entrance,
                               const std::set<VertexId> &component_set, bool conjugate = false) const;
-    bool TraverseLoop(EdgeId start, EdgeId end, const std::set<VertexId> &component_set);
+    // Loop component with single entrance and exit together with the outcome
+    // of the read-only part of its traversal
+    struct LoopCandidate {
+        std::set<VertexId> component_set;
+        EdgeId start;
+        EdgeId finish;
+        // Paths covering start and finish edges at the moment of planning
+        BidirectionalPathSet start_cover_paths;
+        BidirectionalPathSet end_cover_paths;
+        BidirectionalPath *start_path = nullptr;
+        BidirectionalPath *end_path = nullptr;
+        size_t common_size = 0;
+        bool traversable = false;
+    };
+
+    bool PlanTraversal(LoopCandidate &candidate) const;
+    void ApplyTraversal(const LoopCandidate &candidate);
+    bool IsStale(const LoopCandidate &candidate,
+                 const std::set<EdgeId> &changed_edges,
+                 const std::set<const BidirectionalPath*> &changed_paths) const;
     bool ContainsLongEdges(const omnigraph::GraphComponent<debruijn_graph::Graph>& component) const;
     size_t CommonEndSize(const SimpleBidirectionalPath& start_path, const SimpleBidirectionalPath& end_path) const;
 
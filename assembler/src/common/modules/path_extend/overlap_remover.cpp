@@ -6,6 +6,7 @@
 
 #include "overlap_remover.hpp"
 #include "path_extender.hpp" // FIXME: Temporary
+#include "utils/parallel/openmp_wrapper.h"
 
 namespace path_extend {
 
@@ -154,26 +155,14 @@ std::vector<const BidirectionalPath*> OverlapFindingHelper::FindCandidatePaths(c
 }
 
 size_t OverlapRemover::AnalyzeOverlaps(const BidirectionalPath &path, const BidirectionalPath &other,
-                                       bool end_start_only, bool retain_one_copy) const {
-    VERIFY(!retain_one_copy || !end_start_only);
+                                       bool end_start_only, Range &other_range) const {
     auto range_pair = helper_.FindOverlap(path, other, end_start_only);
     size_t overlap = range_pair.first.size();
-    auto other_range = range_pair.second;
+    other_range = range_pair.second;
 
     if (overlap == 0)
         return 0;
 
-    //checking if region on the other path has not been already added
-    //TODO discuss if the logic is needed/correct. It complicates the procedure and prevents trivial parallelism.
-    if (retain_one_copy &&
-        AlreadyAdded(other, other_range.start_pos, other_range.end_pos) &&
-        /*forcing "cut_all" behavior on conjugate paths*/
-        other.GetId() != path.GetConjPath()->GetId() &&
-        /*certain overkill*/
-        other.GetId() != path.GetId()) {
-        return 0;
-    }
-
     if (other.GetId() == path.GetId()) {
         if (overlap == path.Size())
             return 0;
@@ -184,22 +173,48 @@ size_t OverlapRemover::AnalyzeOverlaps(const BidirectionalPath &path, const Bidi
         overlap = std::min(overlap, other.Size() - other_range.end_pos);
     }
 
-    DEBUG("First " << overlap << " edges of the path will be removed");
-    DEBUG(path.str());
-    DEBUG("Due to overlap with path");
-    DEBUG(other.str());
-    DEBUG("Range " << other_range);
-
     return overlap;
 }
 
-void OverlapRemover::MarkStartOverlaps(const BidirectionalPath &path, bool end_start_only, bool retain_one_copy) {
-    std::set<size_t> overlap_poss;
+std::vector<OverlapRemover::StartOverlap> OverlapRemover::FindStartOverlaps(const BidirectionalPath &path,
+                                                                            bool end_start_only) const {
+    std::vector<StartOverlap> answer;
     for (const BidirectionalPath *candidate : helper_.FindCandidatePaths(path)) {
-        size_t overlap = AnalyzeOverlaps(path, *candidate,
-                                         end_start_only, retain_one_copy);
+        Range other_range;
+        size_t overlap = AnalyzeOverlaps(path, *candidate, end_start_only, other_range);
         if (overlap > 0)
-            overlap_poss.insert(overlap);
+            answer.push_back({candidate, other_range, overlap});
+    }
+    return answer;
+}
+
+bool OverlapRemover::IsRetained(const BidirectionalPath &path, const StartOverlap &start_overlap,
+                                bool retain_one_copy) const {
+    const BidirectionalPath &other = *start_overlap.other;
+    //checking if region on the other path has not been already added
+    //NB! Depends on the order in which paths are processed, so it is done in a separate serial pass
+    return retain_one_copy &&
+           AlreadyAdded(other, start_overlap.other_range.start_pos, start_overlap.other_range.end_pos) &&
+           /*forcing "cut_all" behavior on conjugate paths*/
+           other.GetId() != path.GetConjPath()->GetId() &&
+           /*certain overkill*/
+           other.GetId() != path.GetId();
+}
+
+void OverlapRemover::MarkStartOverlaps(const BidirectionalPath &path,
+                                       const std::vector<StartOverlap> &start_overlaps,
+                                       bool retain_one_copy) {
+    std::set<size_t> overlap_poss;
+    for (const auto &start_overlap : start_overlaps) {
+        if (IsRetained(path, start_overlap, retain_one_copy))
+            continue;
+
+        DEBUG("First " << start_overlap.overlap << " edges of the path will be removed");
+        DEBUG(path.str());
+        DEBUG("Due to overlap with path");
+        DEBUG(start_overlap.other->str());
+        DEBUG("Range " << start_overlap.other_range);
+        overlap_poss.insert(start_overlap.overlap);
     }
 
     if (!overlap_poss.empty()) {
@@ -208,19 +223,37 @@ void OverlapRemover::MarkStartOverlaps(const BidirectionalPath &path, bool end_s
 }
 
 void OverlapRemover::InnerMarkOverlaps(bool end_start_only, bool retain_one_copy) {
-    for (auto &path_pair : paths_) {
-        //TODO think if this "optimization" is necessary
-        if (path_pair.first->Size() == 0)
+    VERIFY(!retain_one_copy || !end_start_only);
+    //TODO think if this "optimization" is necessary
+    auto skipped = [this](size_t i) {
+        return paths_.Get(i).Size() == 0 || paths_.Get(i).IsCycle();
+    };
+
+    //Overlaps of path starts are found in parallel: 2 * i for i-th path, 2 * i + 1 for its conjugate
+    std::vector<std::vector<StartOverlap>> start_overlaps(2 * paths_.size());
+#   pragma omp parallel for schedule(dynamic, 16)
+    for (size_t j = 0; j < start_overlaps.size(); ++j) {
+        size_t i = j / 2;
+        if (skipped(i))
+            continue;
+        start_overlaps[j] = FindStartOverlaps(j % 2 ? paths_.GetConjugate(i) : paths_.Get(i), end_start_only);
+    }
+
+    //Splits are marked in the path order, since retaining one copy depends on the splits already marked
+    for (size_t i = 0; i < paths_.size(); ++i) {
+        const BidirectionalPath &path = paths_.Get(i);
+        const BidirectionalPath &conj_path = paths_.GetConjugate(i);
+        if (path.Size() == 0)
             continue;
 
-        if (path_pair.first->IsCycle()) {
-            VERIFY(path_pair.first->GetCycleOverlapping() == path_pair.second->GetCycleOverlapping());
-            auto overlapping = path_pair.first->GetCycleOverlapping();
+        if (path.IsCycle()) {
+            VERIFY(path.GetCycleOverlapping() == conj_path.GetCycleOverlapping());
+            auto overlapping = path.GetCycleOverlapping();
             if (overlapping > 0)
-                splits_[path_pair.first->GetId()].insert(overlapping);
+                splits_[path.GetId()].insert(overlapping);
         } else {
-            MarkStartOverlaps(*path_pair.first, end_start_only, retain_one_copy);
-            MarkStartOverlaps(*path_pair.second, end_start_only, retain_one_copy);
+            MarkStartOverlaps(path, start_overlaps[2 * i], retain_one_copy);
+            MarkStartOverlaps(conj_path, start_overlaps[2 * i + 1], retain_one_copy);
         }
     }
 }
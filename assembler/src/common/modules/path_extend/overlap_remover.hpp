@@ -93,10 +93,22 @@ class OverlapRemover {
         return false;
     }
 
+    //Overlap of the path start with some candidate path
+    struct StartOverlap {
+        const BidirectionalPath *other;
+        Range other_range;
+        size_t overlap;
+    };
+
     //NB! This can only be launched over paths taken from path container!
     size_t AnalyzeOverlaps(const BidirectionalPath &path, const BidirectionalPath &other,
-                           bool end_start_only, bool retain_one_copy) const;
-    void MarkStartOverlaps(const BidirectionalPath &path, bool end_start_only, bool retain_one_copy);
+                           bool end_start_only, Range &other_range) const;
+    //Read-only, can be run for different paths in parallel
+    std::vector<StartOverlap> FindStartOverlaps(const BidirectionalPath &path, bool end_start_only) const;
+    //Depends on the splits marked so far if retain_one_copy is set
+    bool IsRetained(const BidirectionalPath &path, const StartOverlap &start_overlap, bool retain_one_copy) const;
+    void MarkStartOverlaps(const BidirectionalPath &path, const std::vector<StartOverlap> &start_overlaps,
+                           bool retain_one_copy);
     void InnerMarkOverlaps(bool end_start_only, bool retain_one_copy);
 
 public:
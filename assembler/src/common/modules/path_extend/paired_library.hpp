@@ -13,6 +13,11 @@
 
 #include "math/xmath.h"
 
+#include <parallel_hashmap/phmap.h>
+
+#include <algorithm>
+#include <vector>
+
 namespace path_extend {
 
 using debruijn_graph::Graph;
@@ -21,6 +26,67 @@ using debruijn_graph::EdgeId;
 using omnigraph::de::PairedInfoIndexT;
 using omnigraph::de::Point;
 
+// Paired info between two edges reduced to (rounded distance, deviation, weight)
+// bins sorted by distance. Window queries locate the relevant bins by binary
+// search instead of rescanning the whole histogram.
+class BinnedHistogram {
+    struct Bin {
+        int d;
+        int dev;
+        double weight;
+    };
+
+    std::vector<Bin> bins_;
+    int max_dev_ = 0;
+
+    std::vector<Bin>::const_iterator LowerBound(int d) const {
+        return std::lower_bound(bins_.begin(), bins_.end(), d,
+                                [](const Bin &b, int dist) { return b.d < dist; });
+    }
+
+    std::vector<Bin>::const_iterator UpperBound(int d) const {
+        return std::upper_bound(bins_.begin(), bins_.end(), d,
+                                [](int dist, const Bin &b) { return dist < b.d; });
+    }
+
+public:
+    void Add(int d, int dev, double weight) {
+        bins_.push_back({d, dev, weight});
+        max_dev_ = std::max(max_dev_, dev);
+    }
+
+    // Points come sorted by distance from the index already, stable sort
+    // keeps the summation order of the plain histogram scan
+    void Finalize() {
+        auto by_dist = [](const Bin &a, const Bin &b) { return a.d < b.d; };
+        if (!std::is_sorted(bins_.begin(), bins_.end(), by_dist))
+            std::stable_sort(bins_.begin(), bins_.end(), by_dist);
+    }
+
+    bool empty() const { return bins_.empty(); }
+    size_t size() const { return bins_.size(); }
+
+    // Total weight of the points with dist_min <= d <= dist_max
+    double Sum(int dist_min, int dist_max) const {
+        double weight = 0.0;
+        for (auto it = LowerBound(dist_min), end = UpperBound(dist_max); it < end; ++it)
+            weight += it->weight;
+        return weight;
+    }
+
+    // Total weight of the points with d within [distance - dev - ext_left, distance + dev + ext_right],
+    // where dev is the deviation of the point itself
+    double Count(int distance, int ext_left = 0, int ext_right = 0) const {
+        double weight = 0.0;
+        for (auto it = LowerBound(distance - max_dev_ - ext_left),
+                 end = UpperBound(distance + max_dev_ + ext_right); it < end; ++it) {
+            if (it->d >= distance - it->dev - ext_left && it->d <= distance + it->dev + ext_right)
+                weight += it->weight;
+        }
+        return weight;
+    }
+};
+
 class PairedInfoLibrary {
 public:
     PairedInfoLibrary(const Graph& g, size_t read_length, size_t is,
@@ -46,6 +112,14 @@ public:
     virtual void CountDistances(EdgeId e1, EdgeId e2, std::vector<int> &dist, std::vector<double> &w) const = 0;
     virtual double CountPairedInfo(EdgeId e1, EdgeId e2, int distance, bool from_interval = false) const = 0;
     virtual double CountPairedInfo(EdgeId e1, EdgeId e2, int dist_min, int dist_max) const = 0;
+    virtual void FetchPairedInfo(EdgeId e1, EdgeId e2, BinnedHistogram &hist) const = 0;
+
+    // Same as CountPairedInfo(e1, e2, distance, from_interval) over a prefetched histogram
+    double CountPairedInfo(const BinnedHistogram &hist, int distance, bool from_interval = false) const {
+        if (!from_interval)
+            return hist.Count(distance);
+        return hist.Count(distance, (int) (insert_size_ - is_min_), (int) (is_max_ - insert_size_));
+    }
 
     double IdealPairedInfo(EdgeId e1, EdgeId e2, int distance, bool additive = false) const {
         return ideal_pi_counter_.IdealPairedInfo(e1, e2, distance, additive);
@@ -71,6 +145,58 @@ protected:
     DECL_LOGGER("PathExtendPI");
 };
 
+// Binned paired info of the edge pairs queried by the weight counters. Filled in
+// batches, each distinct pair is looked up in the index once. Owned by the caller
+// (e.g. a single extension step) and passed to the counters explicitly, it is not
+// thread-safe. Once more than max_bins bins are stored, the cache is dropped
+// before the next batch is fetched.
+class PairedInfoCache {
+public:
+    typedef std::pair<EdgeId, EdgeId> EdgePair;
+
+    static constexpr size_t DEFAULT_MAX_BINS = 1 << 20;
+
+    explicit PairedInfoCache(size_t max_bins = DEFAULT_MAX_BINS)
+            : max_bins_(max_bins), bins_(0) {}
+
+    // Makes all the pairs available through Get() until the next Fetch()
+    void Fetch(const PairedInfoLibrary &lib, std::vector<EdgePair> pairs) {
+        if (bins_ > max_bins_)
+            clear();
+
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+        for (const EdgePair &p : pairs) {
+            auto it = hists_.find(p);
+            if (it != hists_.end())
+                continue;
+
+            BinnedHistogram &hist = hists_[p];
+            lib.FetchPairedInfo(p.first, p.second, hist);
+            bins_ += hist.size();
+        }
+    }
+
+    const BinnedHistogram &Get(EdgeId e1, EdgeId e2) const {
+        auto it = hists_.find(EdgePair(e1, e2));
+        VERIFY_MSG(it != hists_.end(), "Edge pair was not fetched");
+        return it->second;
+    }
+
+    size_t size() const { return hists_.size(); }
+    size_t bins() const { return bins_; }
+
+    void clear() {
+        hists_.clear();
+        bins_ = 0;
+    }
+
+private:
+    size_t max_bins_;
+    size_t bins_;
+    phmap::flat_hash_map<EdgePair, BinnedHistogram> hists_;
+};
+
 template<class Index>
 class PairedInfoLibraryWithIndex : public PairedInfoLibrary {
     const Index& index_;
@@ -151,6 +277,12 @@ public:
         return weight;
     }
 
+    void FetchPairedInfo(EdgeId e1, EdgeId e2, BinnedHistogram &hist) const override {
+        for (auto point : index_.Get(e1, e2))
+            hist.Add(omnigraph::de::rounded_d(point), (int) point.variance(), point.weight);
+        hist.Finalize();
+    }
+
 };
 
 template<class Index>
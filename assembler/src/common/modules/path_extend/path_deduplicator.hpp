@@ -9,6 +9,10 @@
 #include "overlap_remover.hpp"
 #include "pe_utils.hpp"
 #include "assembly_graph/paths/bidirectional_path.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace path_extend {
 
@@ -17,8 +21,10 @@ class PathDeduplicator {
     const bool equal_only_;
     const OverlapFindingHelper helper_;
 
-    bool IsRedundant(const BidirectionalPath &path) const {
+    //Candidates the path is equal to (or a subpath of), independent of the other paths
+    std::vector<const BidirectionalPath*> FindCovering(const BidirectionalPath &path) const {
         TRACE("Checking if path redundant " << path.GetId());
+        std::vector<const BidirectionalPath*> answer;
         for (const BidirectionalPath *candidate : helper_.FindCandidatePaths(path)) {
             TRACE("Considering candidate " << candidate->GetId());
 //                VERIFY(candidate != path && candidate != path->GetConjPath());
@@ -27,9 +33,9 @@ class PathDeduplicator {
                 continue;
 
             if (equal_only_ ? helper_.IsEqual(path, *candidate) : helper_.IsSubpath(path, *candidate))
-                return true;
+                answer.push_back(candidate);
         }
-        return false;
+        return answer;
     }
 public:
     PathDeduplicator(const Graph &g,
@@ -44,11 +50,19 @@ public:
 
     //TODO use path container filtering?
     void Deduplicate() {
-        for (auto & path_pair : paths_) {
-            auto &path = path_pair.first;
-            if (IsRedundant(*path)) {
-                TRACE("Clearing path " << path->str());
-                path->Clear();
+        //Covering paths are found in parallel, then paths are cleared in order. A path is redundant
+        //if any of its covering paths has not been cleared before (cleared paths leave the coverage map)
+        std::vector<std::vector<const BidirectionalPath*>> covering(paths_.size());
+#       pragma omp parallel for schedule(dynamic, 16)
+        for (size_t i = 0; i < paths_.size(); ++i)
+            covering[i] = FindCovering(paths_.Get(i));
+
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            auto &path = paths_.Get(i);
+            if (std::any_of(covering[i].begin(), covering[i].end(),
+                            [](const BidirectionalPath *p) { return !p->Empty(); })) {
+                TRACE("Clearing path " << path.str());
+                path.Clear();
             }
         }
     }
@@ -10,12 +10,16 @@
 #include "extension_chooser.hpp"
 #include "overlap_analysis.hpp"
 #include "path_filter.hpp"
+#include "seed_container.hpp"
 #include "gap_analyzer.hpp"
 #include "assembly_graph/paths/bidirectional_path.hpp"
 #include "assembly_graph/paths/bidirectional_path_container.hpp"
 #include "assembly_graph/graph_support/detail_coverage.hpp"
 #include "assembly_graph/graph_support/scaff_supplementary.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
+#include <algorithm>
 #include <cmath>
 
 namespace path_extend {
@@ -277,13 +281,22 @@ private:
 //Detects a cycle as a minsuffix > IS present earlier in the path. Overlap is allowed.
 class InsertSizeLoopDetector {
 protected:
-    GraphCoverageMap visited_cycles_coverage_map_;
+    //Only a handful of cycles is ever visited, so they are indexed sparsely,
+    //a dense per-edge map would be allocated by every extender of every worker
+    phmap::flat_hash_map<EdgeId, std::vector<const BidirectionalPath*>> visited_cycles_;
     PathContainer path_storage_;
     size_t min_cycle_len_;
 
+    void AddVisitedCycle(const BidirectionalPath &cycle) {
+        for (EdgeId e : cycle) {
+            auto &cycles = visited_cycles_[e];
+            if (std::find(cycles.begin(), cycles.end(), &cycle) == cycles.end())
+                cycles.push_back(&cycle);
+        }
+    }
+
 public:
-    InsertSizeLoopDetector(const Graph& g, size_t is):
-        visited_cycles_coverage_map_(g),
+    InsertSizeLoopDetector(const Graph&, size_t is):
         path_storage_(),
         min_cycle_len_(is) {
     }
@@ -352,8 +365,12 @@ public:
     //seems that it is outofdate
     bool InExistingLoop(const BidirectionalPath& path) {
         DEBUG("Checking existing loops");
-        for (const auto &entry : visited_cycles_coverage_map_.GetEdgePaths(path.Back())) {
-            const BidirectionalPath &cycle = *entry.first;
+        auto cycles = visited_cycles_.find(path.Back());
+        if (cycles == visited_cycles_.end())
+            return false;
+
+        for (const BidirectionalPath *cycle_ptr : cycles->second) {
+            const BidirectionalPath &cycle = *cycle_ptr;
             DEBUG("checking  cycle ");
             int pos = path.FindLast(cycle);
             if (pos == -1)
@@ -403,7 +420,8 @@ public:
 
         auto p = path_storage_.CreatePair(path.SubPath(pos));
 
-        visited_cycles_coverage_map_.Subscribe(p);
+        AddVisitedCycle(p.first);
+        AddVisitedCycle(p.second);
         DEBUG("add cycle");
         p.first.PrintDEBUG();
     }
@@ -426,7 +444,7 @@ protected:
 class CompositeExtender {
 private:
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage);
-    void GrowAllPaths(PathContainer& paths, PathContainer& result);
+    void GrowSeed(const SeedContainer& seeds, size_t seed, PathContainer& result);
 
 public:
     CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
@@ -437,7 +455,10 @@ public:
               used_storage_(unique),
               extenders_(pes) {}
 
-    void GrowAll(PathContainer& paths, PathContainer& result);
+    //Grows the given seeds in the given order. For every path pair appended to result
+    //the index of the seed it was grown from is appended to origins.
+    void GrowSeeds(const SeedContainer& seeds, const std::vector<size_t>& seed_ids,
+                   PathContainer& result, std::vector<size_t>& origins);
     void GrowPath(BidirectionalPath& path, PathContainer* paths_storage) {
         while (MakeGrowStep(path, paths_storage)) { }
     }
@@ -9,12 +9,6 @@
 
 namespace path_extend {
 
-void CompositeExtender::GrowAll(PathContainer& paths, PathContainer& result) {
-    result.clear();
-    GrowAllPaths(paths, result);
-    result.FilterEmptyPaths();
-}
-
 bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) {
     DEBUG("make grow step composite extender");
 
@@ -29,49 +23,35 @@ bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* pat
     return false;
 }
 
-void CompositeExtender::GrowAllPaths(PathContainer& paths, PathContainer& result) {
-    for (size_t i = 0; i < paths.size(); ++i) {
-        VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
-        if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
-            INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
-        }
-        //In 2015 modes do not use a seed already used in paths.
-        //FIXME what is the logic here?
-        if (used_storage_.UniqueCheckEnabled()) {
-            bool was_used = false;
-            const BidirectionalPath &p = paths.Get(i);
-            for (size_t ind =0; ind < p.Size(); ind++) {
-                EdgeId eid = p.At(ind);
-                auto path_id = p.GetId();
-                if (used_storage_.IsUsedAndUnique(eid, path_id)) {
-                    DEBUG("Used edge " << g_.int_id(eid));
-                    was_used = true;
-                    break;
-                } else {
-                    used_storage_.insert(eid, path_id);
-                }
-            }
-            if (was_used) {
-                DEBUG("skipping already used seed");
-                continue;
-            }
-        }
+void CompositeExtender::GrowSeed(const SeedContainer& seeds, size_t seed, PathContainer& result) {
+    EdgeId e = seeds[seed];
+    //In 2015 modes do not use a seed already used in paths.
+    //FIXME what is the logic here?
+    //The check against the seed itself never fires for a single edge seed, so its edge is only marked as used
+    if (used_storage_.UniqueCheckEnabled())
+        used_storage_.insert(e);
+
+    if (!cover_map_.IsCovered(e)) {
+        BidirectionalPath &path = CreatePath(result, cover_map_, g_, e);
+
+        size_t count_trying = 0;
+        size_t current_path_len = 0;
+        do {
+            current_path_len = path.Length();
+            count_trying++;
+            GrowPath(path, &result);
+            GrowPath(*path.GetConjPath(), &result);
+        } while (count_trying < 10 && (path.Length() != current_path_len));
+        DEBUG("result path " << path.GetId());
+        path.PrintDEBUG();
+    }
+}
 
-        if (!cover_map_.IsCovered(paths.Get(i))) {
-            BidirectionalPath &path = CreatePath(result, cover_map_,
-                                                 paths.Get(i));
-
-            size_t count_trying = 0;
-            size_t current_path_len = 0;
-            do {
-                current_path_len = path.Length();
-                count_trying++;
-                GrowPath(path, &result);
-                GrowPath(*path.GetConjPath(), &result);
-            } while (count_trying < 10 && (path.Length() != current_path_len));
-                DEBUG("result path " << path.GetId());
-                path.PrintDEBUG();
-        }
+void CompositeExtender::GrowSeeds(const SeedContainer& seeds, const std::vector<size_t>& seed_ids,
+                                  PathContainer& result, std::vector<size_t>& origins) {
+    for (size_t seed : seed_ids) {
+        GrowSeed(seeds, seed, result);
+        origins.resize(result.size(), seed);
     }
 }
 
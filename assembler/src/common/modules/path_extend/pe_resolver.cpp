@@ -8,6 +8,7 @@
 #include "overlap_remover.hpp"
 #include "path_deduplicator.hpp"
 #include "path_extender.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 namespace path_extend {
 
@@ -36,21 +37,20 @@ static bool InTwoEdgeCycle(EdgeId e, const Graph &g) {
     return false;
 }
 
-PathContainer PathExtendResolver::MakeSimpleSeeds() const {
-    std::set<EdgeId> included;
-    PathContainer edges;
-    for (EdgeId e : g_.canonical_edges()) {
-        if (g_.int_id(e) <= 0 || InTwoEdgeCycle(e, g_))
-            continue;
-        edges.Create(g_, e);
-    }
-    return edges;
-}
+SeedContainer PathExtendResolver::MakeSimpleSeeds() const {
+    std::vector<EdgeId> edges(g_.canonical_edges().begin(), g_.canonical_edges().end());
+    std::vector<uint8_t> is_seed(edges.size());
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < edges.size(); ++i)
+        is_seed[i] = g_.int_id(edges[i]) > 0 && !InTwoEdgeCycle(edges[i], g_);
 
-PathContainer PathExtendResolver::ExtendSeeds(PathContainer &seeds, CompositeExtender &composite_extender) const {
-    PathContainer paths;
-    composite_extender.GrowAll(seeds, paths);
-    return paths;
+    size_t seeds = 0;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (is_seed[i])
+            edges[seeds++] = edges[i];
+    }
+    edges.resize(seeds);
+    return SeedContainer(std::move(edges));
 }
 
 //Paths should be deduplicated first!
@@ -9,10 +9,10 @@
 
 #include "assembly_graph/paths/bidirectional_path.hpp"
 #include "assembly_graph/paths/bidirectional_path_container.hpp"
+#include "seed_container.hpp"
 
 namespace path_extend {
 
-class CompositeExtender;
 class GraphCoverageMap;
 
 void Deduplicate(const debruijn_graph::Graph &g, PathContainer &paths, GraphCoverageMap &coverage_map,
@@ -26,8 +26,7 @@ public:
     PathExtendResolver(const debruijn_graph::Graph& g)
             : g_(g), k_(g.k()) {}
     
-    PathContainer MakeSimpleSeeds() const;
-    PathContainer ExtendSeeds(PathContainer &seeds, CompositeExtender &composite_extender) const;
+    SeedContainer MakeSimpleSeeds() const;
 
     //Paths should be deduplicated first!
     void RemoveOverlaps(PathContainer &paths, GraphCoverageMap &coverage_map,
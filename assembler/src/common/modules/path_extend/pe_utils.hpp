@@ -13,7 +13,12 @@
 #include "assembly_graph/paths/bidirectional_path_container.hpp"
 
 #include "adt/flat_map.hpp"
-#include "parallel_hashmap/phmap.h"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <vector>
 
 namespace path_extend {
 
@@ -21,43 +26,137 @@ using namespace debruijn_graph;
 
 // Handles all paths in PathContainer.
 // For each edge output all paths  that _traverse_ this path. If path contains multiple instances - count them. Position of the edge is not reported.
+// Coverage is stored densely by edge id and allocated on the first update. Concurrent reads are safe while paths are not modified.
 class GraphCoverageMap: public PathListener {
 public:
     typedef adt::flat_map<BidirectionalPath*, size_t> MapDataT;
 
+    // Iterates over covered edges only, yielding (edge, its paths) pairs
+    class ConstIterator : public boost::iterator_facade<ConstIterator,
+                                                        const std::pair<EdgeId, const MapDataT&>,
+                                                        boost::forward_traversal_tag,
+                                                        std::pair<EdgeId, const MapDataT&>> {
+        std::vector<MapDataT>::const_iterator it_, end_, begin_;
+
+        void SkipEmpty() {
+            while (it_ != end_ && it_->empty())
+                ++it_;
+        }
+
+    public:
+        ConstIterator(std::vector<MapDataT>::const_iterator it,
+                      std::vector<MapDataT>::const_iterator begin,
+                      std::vector<MapDataT>::const_iterator end)
+                : it_(it), end_(end), begin_(begin) {
+            SkipEmpty();
+        }
+
+    private:
+        friend class boost::iterator_core_access;
+
+        void increment() {
+            ++it_;
+            SkipEmpty();
+        }
+
+        bool equal(const ConstIterator &other) const {
+            return it_ == other.it_;
+        }
+
+        std::pair<EdgeId, const MapDataT&> dereference() const {
+            return { EdgeId(uint64_t(it_ - begin_)), *it_ };
+        }
+    };
+
 private:
+    typedef std::vector<std::pair<size_t, BidirectionalPath*>> EdgeEntries;
+
     const Graph& g_;
 
-    phmap::parallel_flat_hash_map<EdgeId, MapDataT> edge_coverage_;
+    std::vector<MapDataT> edge_coverage_;
+    size_t covered_edges_;
     const MapDataT empty_;
 
+    void Reserve(size_t edge_id) {
+        if (edge_id >= edge_coverage_.size())
+            edge_coverage_.resize(std::max(edge_id + 1, (size_t) g_.max_eid()));
+    }
+
+    const MapDataT *EdgeData(EdgeId e) const {
+        size_t id = e.int_id();
+        return id < edge_coverage_.size() ? &edge_coverage_[id] : nullptr;
+    }
+
     void EdgeAdded(EdgeId e, BidirectionalPath &path) {
-        edge_coverage_[e][&path] += 1;
+        Reserve(e.int_id());
+        auto &data = edge_coverage_[e.int_id()];
+        if (data.empty()) {
+#           pragma omp atomic
+            covered_edges_ += 1;
+        }
+        data[&path] += 1;
     }
 
     void EdgeRemoved(EdgeId e, BidirectionalPath &path) {
-        auto iter = edge_coverage_.find(e);
-        if (iter == edge_coverage_.end())
+        size_t id = e.int_id();
+        if (id >= edge_coverage_.size())
             return;
 
-        auto entry = iter->second.find(&path);
-        if (entry == iter->second.end()) {
+        auto &data = edge_coverage_[id];
+        auto entry = data.find(&path);
+        if (entry == data.end()) {
             DEBUG("Error erasing path from coverage map");
         } else {
             if (entry->second > 1)
                 entry->second -= 1;
             else
-                iter->second.erase(entry);
+                data.erase(entry);
+            if (data.empty()) {
+#               pragma omp atomic
+                covered_edges_ -= 1;
+            }
         }
     }
 
-    void ProcessPath(BidirectionalPath &path, bool subscribe) {
+    void CollectEdges(BidirectionalPath &path, bool subscribe, EdgeEntries &entries) {
         if (subscribe)
             path.Subscribe(*this);
-        
-        for (size_t i = 0; i < path.Size(); ++i) {
-            EdgeAdded(path.At(i), path);
+
+        for (EdgeId e : path)
+            entries.emplace_back(e.int_id(), &path);
+    }
+
+    // Batched update: entries are grouped by edge, so different edges are updated in parallel
+    void AddEdges(EdgeEntries &entries) {
+        if (entries.empty())
+            return;
+
+        std::sort(entries.begin(), entries.end());
+        Reserve(entries.back().first);
+
+        std::vector<size_t> group_starts;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (i == 0 || entries[i].first != entries[i - 1].first)
+                group_starts.push_back(i);
+        }
+        group_starts.push_back(entries.size());
+
+        size_t newly_covered = 0;
+#       pragma omp parallel for schedule(dynamic, 1024) reduction(+ : newly_covered) if (group_starts.size() > 4096)
+        for (size_t group = 0; group < group_starts.size() - 1; ++group) {
+            auto &data = edge_coverage_[entries[group_starts[group]].first];
+            newly_covered += data.empty();
+            for (size_t i = group_starts[group]; i < group_starts[group + 1]; ++i)
+                data[entries[i].second] += 1;
         }
+#       pragma omp atomic
+        covered_edges_ += newly_covered;
+    }
+
+    void ProcessPath(BidirectionalPath &path, bool subscribe) {
+        EdgeEntries entries;
+        CollectEdges(path, subscribe, entries);
+        AddEdges(entries);
     }
 
 public:
@@ -66,10 +165,7 @@ public:
 
     GraphCoverageMap(GraphCoverageMap&&) = default;
 
-    explicit GraphCoverageMap(const Graph& g) : g_(g) {
-        //FIXME heavy constructor
-        edge_coverage_.reserve(g_.e_size());
-    }
+    explicit GraphCoverageMap(const Graph& g) : g_(g), covered_edges_(0) {}
 
     GraphCoverageMap(const Graph& g, const PathContainer& paths, bool subscribe = false) :
             GraphCoverageMap(g) {
@@ -78,11 +174,20 @@ public:
 
     ~GraphCoverageMap() {}
 
+    //Allocates slots for all graph edges in advance. After that paths with
+    //disjoint edge sets can be added and updated from different threads.
+    void ReserveAll() {
+        if (g_.max_eid() > 0)
+            Reserve(g_.max_eid() - 1);
+    }
+
     void AddPaths(const PathContainer& paths, bool subscribe = false) {
+        EdgeEntries entries;
         for (auto &path_pair : paths) {
-            ProcessPath(*path_pair.first, subscribe);
-            ProcessPath(*path_pair.second, subscribe);
+            CollectEdges(*path_pair.first, subscribe, entries);
+            CollectEdges(*path_pair.second, subscribe, entries);
         }
+        AddEdges(entries);
     }
 
     void Subscribe(BidirectionalPath &path) {
@@ -90,8 +195,10 @@ public:
     }
 
     void Subscribe(std::pair<BidirectionalPath&, BidirectionalPath&> ppair) {
-        ProcessPath(ppair.first, true);
-        ProcessPath(ppair.second, true);
+        EdgeEntries entries;
+        CollectEdges(ppair.first, true, entries);
+        CollectEdges(ppair.second, true, entries);
+        AddEdges(entries);
     }
 
     //Inherited from PathListener
@@ -115,25 +222,22 @@ public:
     }
 
     const MapDataT &GetEdgePaths(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        if (iter != edge_coverage_.end()) {
-            return iter->second;
-        }
-        return empty_;
+        const MapDataT *data = EdgeData(e);
+        return data ? *data : empty_;
     }
 
     size_t Count(EdgeId e, const BidirectionalPath &path) const {
-        auto entry = edge_coverage_.find(e);
-        if (entry == edge_coverage_.end())
+        const MapDataT *data = EdgeData(e);
+        if (!data)
             return 0;
 
-        auto cov = entry->second.find(const_cast<BidirectionalPath*>(&path));
-        return (cov == entry->second.end() ? 0 : cov->second);
+        auto cov = data->find(const_cast<BidirectionalPath*>(&path));
+        return (cov == data->end() ? 0 : cov->second);
     }
 
     size_t GetCoverage(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        return (iter != edge_coverage_.end() ? iter->second.size() : 0);
+        const MapDataT *data = EdgeData(e);
+        return (data ? data->size() : 0);
     }
 
     bool IsCovered(EdgeId e) const {
@@ -150,26 +254,27 @@ public:
 
     BidirectionalPathSet GetCoveringPaths(EdgeId e) const {
         BidirectionalPathSet res;
-        auto iter = edge_coverage_.find(e);
-        if (iter == edge_coverage_.end())
+        const MapDataT *data = EdgeData(e);
+        if (!data)
             return res;
 
-        for (const auto &entry : iter->second)
+        for (const auto &entry : *data)
             res.insert(entry.first);
 
         return res;
     }
 
-    auto begin() const {
-        return edge_coverage_.begin();
+    ConstIterator begin() const {
+        return ConstIterator(edge_coverage_.begin(), edge_coverage_.begin(), edge_coverage_.end());
     }
 
-    auto end() const {
-        return edge_coverage_.end();
+    ConstIterator end() const {
+        return ConstIterator(edge_coverage_.end(), edge_coverage_.begin(), edge_coverage_.end());
     }
 
+    // Number of covered edges
     size_t size() const {
-        return edge_coverage_.size();
+        return covered_edges_;
     }
 
     const Graph& graph() const {
@@ -84,6 +84,9 @@ class ExtendersGenerator {
 
     const PELaunchSupport &support_;
 
+    //Extenders are built once per extension worker, only the first set is reported at INFO level
+    logging::level log_level_;
+
 public:
     ExtendersGenerator(const config::dataset &dataset_info,
                        const PathExtendParamsContainer &params,
@@ -91,7 +94,8 @@ public:
                        const GraphCoverageMap &cover_map,
                        const UniqueData &unique_data,
                        UsedUniqueStorage &used_unique_storage,
-                       const PELaunchSupport& support) :
+                       const PELaunchSupport& support,
+                       logging::level log_level = logging::L_INFO) :
         dataset_info_(dataset_info),
         params_(params),
         gp_(gp),
@@ -99,7 +103,8 @@ public:
         cover_map_(cover_map),
         unique_data_(unique_data),
         used_unique_storage_(used_unique_storage),
-        support_(support) { }
+        support_(support),
+        log_level_(log_level) { }
 
     Extenders MakePBScaffoldingExtenders() const;
 
@@ -18,6 +18,12 @@
 #include "modules/path_extend/scaffolder2015/scaffold_graph_visualizer.hpp"
 #include "modules/path_extend/scaffolder2015/scaffold_graph_constructor.hpp"
 #include "modules/path_extend/scaffolder2015/path_polisher.hpp"
+#include "adt/concurrent_dsu.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/memory_limit.hpp"
+
+#include <numeric>
+#include <tuple>
 
 #include <unordered_set>
 
@@ -319,7 +325,7 @@ void PathExtendLauncher::AddScaffUniqueStorage(size_t uniqe_edge_len) {
     additional_edge_analyzer.FillUniqueEdgeStorage(unique_data_.unique_storages_.back());
 }
 
-Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &generator) {
+void PathExtendLauncher::FillMPUniqueEdgeStorages() {
     const pe_config::ParamSetT &pset = params_.pset;
 
     size_t cur_length = unique_data_.min_unique_length_ - pset.scaffolding2015.unique_length_step;
@@ -334,8 +340,6 @@ Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &gen
         INFO("Will add final extenders for length " << lower_bound);
         AddScaffUniqueStorage(lower_bound);
     }
-
-    return generator.MakeMPExtenders();
 }
 
 void PathExtendLauncher::FillPathContainer(size_t lib_index, size_t size_threshold) {
@@ -377,6 +381,28 @@ void PathExtendLauncher::FillLongReadsCoverageMaps() {
     }
 }
 
+//Unique edges of long read libraries are read-only during extension, so they are
+//found once here and shared by the choosers of every extender set
+void PathExtendLauncher::FillLongReadsUniqueEdges() {
+    unique_data_.long_reads_unique_edges_.resize(dataset_info_.reads.lib_count());
+    if (params_.pset.multi_path_extend || cfg::get().pd)
+        return;
+
+    for (size_t lib_index = 0; lib_index < dataset_info_.reads.lib_count(); lib_index++) {
+        const auto &lib = dataset_info_.reads[lib_index];
+        if (!support_.IsForSingleReadExtender(lib))
+            continue;
+
+        auto long_reads_config = support_.GetLongReadsConfig(lib.type());
+        unique_data_.long_reads_unique_edges_[lib_index] =
+            std::make_shared<LongReadsUniqueEdgeAnalyzer>(graph_, unique_data_.long_reads_cov_map_[lib_index],
+                                                          long_reads_config.filtering,
+                                                          long_reads_config.unique_edge_priority,
+                                                          params_.pset.extension_options.max_repeat_length,
+                                                          params_.uneven_depth);
+    }
+}
+
 void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     //FIXME magic constants
     //FIXME need to change for correct usage of prelimnary contigs in loops
@@ -407,19 +433,30 @@ void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     INFO(unique_data_.unique_pb_storage_.size() << " unique edges");
 }
 
-Extenders PathExtendLauncher::ConstructPBExtenders(const ExtendersGenerator &generator) {
-    FillPBUniqueEdgeStorages();
-    return generator.MakePBScaffoldingExtenders();
-}
+//Fills the data shared by all extender sets, must be called once before ConstructExtenders
+void PathExtendLauncher::PrepareExtenders() {
+    bool is_plasmid = config::PipelineHelper::IsPlasmidPipeline(params_.mode);
+    if (!is_plasmid && (support_.SingleReadsMapped() || support_.HasLongReads())) {
+        FillLongReadsCoverageMaps();
+        FillLongReadsUniqueEdges();
+    }
 
+    if (params_.pset.sm == scaffolding_mode::sm_old)
+        return;
+
+    if (!is_plasmid && support_.HasLongReads())
+        FillPBUniqueEdgeStorages();
+
+    if (support_.HasMPReads())
+        FillMPUniqueEdgeStorages();
+}
 
 Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
-                                                 UsedUniqueStorage &used_unique_storage) {
-    INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
-    if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) &&  (support_.SingleReadsMapped() || support_.HasLongReads()))
-        FillLongReadsCoverageMaps();
+                                                 UsedUniqueStorage &used_unique_storage,
+                                                 logging::level log_level) const {
+    LOG_MSG(log_level, "Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
     ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
-                                 unique_data_, used_unique_storage, support_);
+                                 unique_data_, used_unique_storage, support_, log_level);
     Extenders extenders = generator.MakeBasicExtenders();
     DEBUG("Total number of basic extenders is " << extenders.size());
 
@@ -427,27 +464,166 @@ Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_m
 
     if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) && support_.HasLongReads()) {
         if (params_.pset.sm == scaffolding_mode::sm_old) {
-            INFO("Will not use new long read scaffolding algorithm in this mode");
+            LOG_MSG(log_level, "Will not use new long read scaffolding algorithm in this mode");
         } else {
-            utils::push_back_all(extenders, ConstructPBExtenders(generator));
+            utils::push_back_all(extenders, generator.MakePBScaffoldingExtenders());
         }
     }
 
     if (support_.HasMPReads()) {
         if (params_.pset.sm == scaffolding_mode::sm_old) {
-            INFO("Will not use mate-pairs is this mode");
+            LOG_MSG(log_level, "Will not use mate-pairs is this mode");
         } else {
-            utils::push_back_all(extenders, ConstructMPExtenders(generator));
+            utils::push_back_all(extenders, generator.MakeMPExtenders());
         }
     }
 
     if (params_.pset.use_coordinated_coverage)
         utils::push_back_all(extenders, generator.MakeCoverageExtenders());
 
-    INFO("Total number of extenders is " << extenders.size());
+    LOG_MSG(log_level, "Total number of extenders is " << extenders.size());
     return extenders;
 }
 
+template<class Index>
+static void UniteByPairedInfo(const Index &index, dsu::ConcurrentDSU &components) {
+    for (auto it = index.data_begin(); it != index.data_end(); ++it) {
+        for (const auto &entry : it->second)
+            components.unite(it->first.int_id(), entry.first.int_id());
+    }
+}
+
+//Groups seeds by the connected component of the graph condensed with all the links extenders
+//can follow: graph adjacency, conjugate edges, paired info and long read paths.
+//Extension in different components does not interact.
+std::vector<std::vector<size_t>> PathExtendLauncher::PartitionSeeds(const SeedContainer &seeds) const {
+    dsu::ConcurrentDSU components(graph_.max_eid());
+    for (VertexId v : graph_) {
+        EdgeId first;
+        for (EdgeId e : graph_.IncidentEdges(v)) {
+            if (first == EdgeId())
+                first = e;
+            components.unite(first.int_id(), e.int_id());
+        }
+    }
+    for (EdgeId e : graph_.canonical_edges())
+        components.unite(e.int_id(), graph_.conjugate(e).int_id());
+
+    const auto &clustered_indices = gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices");
+    const auto &scaffolding_indices = gp_.get<PairedInfoIndicesT<Graph>>("scaffolding_indices");
+    const auto &paired_indices = gp_.get<UnclusteredPairedInfoIndicesT<Graph>>();
+    for (size_t lib_index = 0; lib_index < dataset_info_.reads.lib_count(); ++lib_index) {
+        UniteByPairedInfo(clustered_indices[lib_index], components);
+        UniteByPairedInfo(scaffolding_indices[lib_index], components);
+        UniteByPairedInfo(paired_indices[lib_index], components);
+    }
+
+    for (const auto &long_reads : unique_data_.long_reads_paths_) {
+        for (const auto &path_pair : long_reads) {
+            const BidirectionalPath &path = *path_pair.first;
+            for (size_t i = 1; i < path.Size(); ++i)
+                components.unite(path[0].int_id(), path[i].int_id());
+        }
+    }
+
+    //Components are numbered in the order of their first seed
+    std::vector<std::vector<size_t>> result;
+    std::unordered_map<size_t, size_t> component_ids;
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        size_t root = components.find_set(seeds[i].int_id());
+        auto it = component_ids.emplace(root, result.size()).first;
+        if (it->second == result.size())
+            result.emplace_back();
+        result[it->second].push_back(i);
+    }
+    return result;
+}
+
+//Memory an extender set takes on top of the shared data: what building the first set allocated
+//plus the bound on the paired info cache of an extension step (DEFAULT_MAX_BINS bins of 16 bytes
+//plus pair overhead). Used unique edges and loop detector state grow with the extended component
+//and are not accounted for.
+static size_t ExtenderSetMemory(size_t construction_memory) {
+    const size_t cached_bin_bytes = 32;
+    return construction_memory + PairedInfoCache::DEFAULT_MAX_BINS * cached_bin_bytes;
+}
+
+//Seeds of different components are grown on worker threads, each with its own extenders and
+//used unique storage. The coverage map is shared: its slots are preallocated and components never
+//touch the same edges. Results are merged in the seed order, as a serial run would produce them.
+PathContainer PathExtendLauncher::ExtendSeeds(const SeedContainer &seeds) const {
+    auto components = PartitionSeeds(seeds);
+
+    GraphCoverageMap cover_map(graph_);
+    cover_map.ReserveAll();
+    std::vector<std::unique_ptr<UsedUniqueStorage>> used_storages;
+    std::vector<std::unique_ptr<CompositeExtender>> composite_extenders;
+    auto add_worker = [&](logging::level log_level) {
+        used_storages.push_back(std::make_unique<UsedUniqueStorage>(unique_data_.main_unique_storage_, graph_));
+        composite_extenders.push_back(std::make_unique<CompositeExtender>(graph_, cover_map, *used_storages.back(),
+                                                                          ConstructExtenders(cover_map,
+                                                                                             *used_storages.back(),
+                                                                                             log_level)));
+    };
+
+    //Only the first extender set reports its configuration, the others are identical and are
+    //built only for the workers that fit into the memory left
+    size_t memory_limit = utils::get_memory_limit(), used_before = utils::get_used_memory();
+    add_worker(logging::L_INFO);
+    size_t used_memory = utils::get_used_memory();
+    size_t set_memory = ExtenderSetMemory(used_memory > used_before ? used_memory - used_before : 0);
+    size_t free_memory = used_memory < memory_limit ? memory_limit - used_memory : 0;
+    size_t workers = std::max(size_t(1), std::min({size_t(omp_get_max_threads()), components.size(),
+                                                   free_memory / set_memory}));
+    INFO("Extending " << seeds.size() << " seeds from " << components.size() << " independent components"
+         " using " << workers << " threads");
+    while (composite_extenders.size() < workers)
+        add_worker(logging::L_DEBUG);
+
+    //Larger components are scheduled first
+    std::vector<size_t> order(components.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return components[a].size() > components[b].size();
+    });
+
+    std::vector<PathContainer> component_paths(components.size());
+    std::vector<std::vector<size_t>> origins(components.size());
+    size_t processed = 0;
+#   pragma omp parallel for num_threads(workers) schedule(dynamic, 1)
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t c = order[i];
+        composite_extenders[omp_get_thread_num()]->GrowSeeds(seeds, components[c],
+                                                             component_paths[c], origins[c]);
+        size_t done;
+#       pragma omp atomic capture
+        done = processed += components[c].size();
+        if (seeds.size() > 10 && done * 10 / seeds.size() != (done - components[c].size()) * 10 / seeds.size()) {
+            INFO("Processed " << done << " paths from " << seeds.size() << " (" << done * 100 / seeds.size() << "%)");
+        }
+    }
+
+    //Paths are cloned in the merged order, so path ids do not depend on scheduling
+    std::vector<std::tuple<size_t, size_t, size_t>> merged;
+    for (size_t c = 0; c < components.size(); ++c) {
+        for (size_t j = 0; j < component_paths[c].size(); ++j) {
+            if (!component_paths[c].Get(j).Empty())
+                merged.emplace_back(origins[c][j], c, j);
+        }
+    }
+    std::sort(merged.begin(), merged.end());
+
+    PathContainer result;
+    result.reserve(merged.size());
+    for (const auto &entry : merged) {
+        const PathContainer &paths = component_paths[std::get<1>(entry)];
+        size_t j = std::get<2>(entry);
+        auto path = BidirectionalPath::clone(paths.Get(j));
+        result.AddPair(std::move(path), BidirectionalPath::clone(paths.GetConjugate(j)));
+    }
+    return result;
+}
+
 void PathExtendLauncher::PolishPaths(const PathContainer &paths, PathContainer &result,
                                      const GraphCoverageMap& /* cover_map */) const {
     //Fixes distances for paths gaps and tries to fill them in
@@ -620,22 +796,19 @@ void PathExtendLauncher::Launch() {
 
     auto seeds = resolver.MakeSimpleSeeds();
 
-    seeds.SortByLength();
-    DebugOutputPaths(seeds, "init_paths");
+    seeds.SortByLength(graph_);
+    if (params_.pe_cfg.debug_output)
+        DebugOutputPaths(seeds.ToPaths(graph_), "init_paths");
 
     if (params_.pe_cfg.debug_output)
         MakeConjugateEdgePairsDump(graph_);
 
-    GraphCoverageMap cover_map(graph_);
-    UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_, graph_);
-    Extenders extenders = ConstructExtenders(cover_map, used_unique_storage);
-    CompositeExtender composite_extender(graph_, cover_map,
-                                         used_unique_storage,
-                                         extenders);
-
-    auto paths = resolver.ExtendSeeds(seeds, composite_extender);
+    PrepareExtenders();
+    auto paths = ExtendSeeds(seeds);
     DebugOutputPaths(paths, "raw_paths");
 
+    GraphCoverageMap cover_map(graph_, paths, true);
+
     RemoveOverlapsAndArtifacts(paths, cover_map, resolver);
     DebugOutputPaths(paths, "before_path_polishing");
 
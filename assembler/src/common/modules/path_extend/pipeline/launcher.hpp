@@ -58,6 +58,8 @@ class PathExtendLauncher {
 
     void FillLongReadsCoverageMaps();
 
+    void FillLongReadsUniqueEdges();
+
     void DebugOutputPaths(const PathContainer &paths, const std::string &name) const;
 
     void RemoveOverlapsAndArtifacts(PathContainer &paths, GraphCoverageMap &cover_map, const PathExtendResolver &resolver) const;
@@ -70,13 +72,18 @@ class PathExtendLauncher {
 
     void PolishPaths(const PathContainer &paths, PathContainer &result, const GraphCoverageMap &cover_map) const;
 
-    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage);
+    void PrepareExtenders();
+
+    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage,
+                                 logging::level log_level = logging::L_INFO) const;
 
-    Extenders ConstructMPExtenders(const ExtendersGenerator &generator);
+    void FillMPUniqueEdgeStorages();
 
     void AddScaffUniqueStorage(size_t uniqe_edge_len);
 
-    Extenders ConstructPBExtenders(const ExtendersGenerator &generator);
+    std::vector<std::vector<size_t>> PartitionSeeds(const SeedContainer &seeds) const;
+
+    PathContainer ExtendSeeds(const SeedContainer &seeds) const;
 
     void FilterPaths();
 
@@ -1,5 +1,6 @@
 #include "connection_condition2015.hpp"
 #include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 namespace path_extend {
 
@@ -233,13 +234,22 @@ AssemblyGraphConnectionCondition::AssemblyGraphConnectionCondition(const debruij
 Connections AssemblyGraphConnectionCondition::ConnectedWith(debruijn_graph::EdgeId e) const {
     VERIFY_MSG(interesting_edge_set_.find(e) != interesting_edge_set_.end(),
                " edge "<< e.int_id() << " not applicable for connection condition");
-    if (stored_distances_.find(e) != stored_distances_.end()) {
-        return stored_distances_[e];
+    bool cached = false;
+    Connections result;
+#   pragma omp critical(assembly_graph_connections)
+    {
+        auto entry = stored_distances_.find(e);
+        if (entry != stored_distances_.end()) {
+            result = entry->second;
+            cached = true;
+        }
     }
-    stored_distances_.emplace(e, Connections());
+    if (cached)
+        return result;
+
     for (auto connected: g_.OutgoingEdges(g_.EdgeEnd(e))) {
         if (interesting_edge_set_.find(connected) != interesting_edge_set_.end()) {
-            stored_distances_[e].emplace(connected, 1);
+            result.emplace(connected, 1);
         }
     }
     auto dijkstra = omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_, max_connection_length_);
@@ -247,11 +257,14 @@ Connections AssemblyGraphConnectionCondition::ConnectedWith(debruijn_graph::Edge
     for (auto v: dijkstra.ReachedVertices()) {
         for (auto connected: g_.OutgoingEdges(v)) {
             if (interesting_edge_set_.find(connected) != interesting_edge_set_.end() && dijkstra.GetDistance(v) < max_connection_length_) {
-                stored_distances_[e].emplace(connected, 1);
+                result.emplace(connected, 1);
             }
         }
     }
-    return stored_distances_[e];
+
+#   pragma omp critical(assembly_graph_connections)
+    stored_distances_.emplace(e, result);
+    return result;
 }
 void AssemblyGraphConnectionCondition::AddInterestingEdges(func::TypedPredicate<typename Graph::EdgeId> edge_condition) {
     for (EdgeId e : g_.edges()) {
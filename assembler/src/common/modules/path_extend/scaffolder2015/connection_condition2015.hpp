@@ -133,6 +133,7 @@ protected:
 //Maximal gap to the connection.
     size_t max_connection_length_;
     EdgeSet interesting_edge_set_;
+    // Accessed under omp critical(assembly_graph_connections)
     mutable std::map<EdgeId, Connections> stored_distances_;
 public:
     AssemblyGraphConnectionCondition(const Graph &g, size_t max_connection_length,
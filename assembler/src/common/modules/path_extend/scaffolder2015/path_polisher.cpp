@@ -7,6 +7,9 @@
 #include "path_polisher.hpp"
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/paths/bidirectional_path.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
 
 namespace path_extend {
 
@@ -23,10 +26,25 @@ void PathPolisher::InfoAboutGaps(const PathContainer & result){
 }
 
 PathContainer PathPolisher::PolishPaths(const PathContainer &paths) {
+    bool thread_safe = std::all_of(gap_closers_.begin(), gap_closers_.end(),
+                                   [](const std::shared_ptr<PathGapCloser> &gap_closer) {
+                                       return gap_closer->IsThreadSafe();
+                                   });
+
+    //Paths are polished independently, every gap closer runs its own Dijkstra
+    std::vector<std::unique_ptr<BidirectionalPath>> polished(paths.size());
+#   pragma omp parallel for schedule(dynamic, 1) if (thread_safe)
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto path = Polish(paths.Get(i));
+        polished[i] = Polish(path->Conjugate());
+    }
+
+    //Resulting paths are created in the original order, so their ids do not depend on scheduling
     PathContainer result;
-    for (const auto& path_pair : paths) {
-        auto path = Polish(*path_pair.first);
-        auto conjugate_path = Polish(path->Conjugate());
+    result.reserve(paths.size());
+    for (auto &polished_path : polished) {
+        auto conjugate_path = BidirectionalPath::clone(*polished_path);
+        polished_path.reset();
         auto re_path = BidirectionalPath::clone_conjugate(conjugate_path);
         result.AddPair(std::move(re_path), std::move(conjugate_path));
     }
@@ -43,7 +61,7 @@ size_t DijkstraGapCloser::MinPathLength(const PathsT& paths) const {
     return shortest_len;
 }
 
-std::unique_ptr<BidirectionalPath> PathPolisher::Polish(const BidirectionalPath &init_path) {
+std::unique_ptr<BidirectionalPath> PathPolisher::Polish(const BidirectionalPath &init_path) const {
     auto path = BidirectionalPath::clone(init_path);
 
     if (init_path.Empty())
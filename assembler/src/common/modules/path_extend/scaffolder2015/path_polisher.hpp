@@ -28,6 +28,9 @@ protected:
 public:
     std::unique_ptr<BidirectionalPath> CloseGaps(const BidirectionalPath &path) const;
 
+    //Whether CloseGaps can be called for different paths concurrently
+    virtual bool IsThreadSafe() const { return true; }
+
     PathGapCloser(const Graph& g, size_t max_path_len):
                   g_(g),
                   max_path_len_(max_path_len),
@@ -65,6 +68,9 @@ public:
             TargetEdgeGapCloser(g, max_path_len), extender_(extender) {
         DEBUG("ext added");
     }
+
+    //Extenders keep their own state
+    bool IsThreadSafe() const override { return false; }
 };
 
 class MatePairGapCloser: public TargetEdgeGapCloser {
@@ -125,7 +131,7 @@ class PathPolisher {
 
     void InfoAboutGaps(const PathContainer& result);
 
-    std::unique_ptr<BidirectionalPath> Polish(const BidirectionalPath& path);
+    std::unique_ptr<BidirectionalPath> Polish(const BidirectionalPath& path) const;
     DECL_LOGGER("PathPolisher")
 
 public:
@@ -253,5 +253,11 @@ bool ScaffoldGraph::AddEdge(const ScaffoldGraph::ScaffoldEdge &e) {
     return AddEdge(e.getStart(), e.getEnd(), e.getColor(), e.getWeight());
 }
 
+void ScaffoldGraph::ReserveEdges(size_t edge_count) {
+    edges_.reserve(edge_count);
+    outgoing_edges_.reserve(edge_count);
+    incoming_edges_.reserve(edge_count);
+}
+
 } //scaffold_graph
 } //path_extend
@@ -167,6 +167,9 @@ public:
 
     bool AddEdge(const ScaffoldEdge &e);
 
+    //Preallocate storage for bulk edge addition
+    void ReserveEdges(size_t edge_count);
+
     //Rempve edge from edge container and all adjacency lists
     bool RemoveEdge(const ScaffoldEdge &e);
 
@@ -4,6 +4,8 @@
 
 #include "scaffold_graph_constructor.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 namespace path_extend {
 
 namespace scaffold_graph {
@@ -39,23 +41,42 @@ void BaseScaffoldGraphConstructor::ConstructFromConditions(ConnectionConditions
 
 void BaseScaffoldGraphConstructor::ConstructFromSingleCondition(const std::shared_ptr<ConnectionCondition> condition,
                                                                 bool use_terminal_vertices_only) {
-    for (const auto& v : graph_->vertices()) {
-        TRACE("Vertex " << graph_->int_id(v));
+    typedef ScaffoldGraph::ScaffoldVertex ScaffoldVertex;
+    std::vector<ScaffoldVertex> vertices(graph_->vbegin(), graph_->vend());
 
+    // Connection queries (e.g. bounded Dijkstra runs) are independent, so evaluate them in parallel.
+    // Edges are added afterwards in the vertex order, since the terminal vertex check depends on the
+    // edges added before
+    std::vector<std::vector<std::pair<EdgeId, double>>> connections(vertices.size());
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        ScaffoldVertex v = vertices[i];
         if (use_terminal_vertices_only && graph_->OutgoingEdgeCount(v) > 0)
             continue;
 
-        auto connected_with = condition->ConnectedWith(v);
-        for (const auto& pair : connected_with) {
+        for (const auto& pair : condition->ConnectedWith(v)) {
+            if (graph_->Exists(pair.first))
+                connections[i].push_back(pair);
+        }
+    }
+
+    size_t total = 0;
+    for (const auto &connected_with : connections)
+        total += connected_with.size();
+    graph_->ReserveEdges(graph_->EdgeCount() + total);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        ScaffoldVertex v = vertices[i];
+        TRACE("Vertex " << graph_->int_id(v));
+        for (const auto& pair : connections[i]) {
             EdgeId connected = pair.first;
             double w = pair.second;
             TRACE("Connected with " << graph_->int_id(connected));
-            if (graph_->Exists(connected)) {
-                if (use_terminal_vertices_only && graph_->IncomingEdgeCount(connected) > 0)
-                    continue;
-                graph_->AddEdge(v, connected, condition->GetLibIndex(), w);
-            }
+            if (use_terminal_vertices_only && graph_->IncomingEdgeCount(connected) > 0)
+                continue;
+            graph_->AddEdge(v, connected, condition->GetLibIndex(), w);
         }
+        std::vector<std::pair<EdgeId, double>>().swap(connections[i]);
     }
 }
 
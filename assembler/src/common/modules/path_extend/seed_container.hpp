@@ -0,0 +1,59 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/paths/bidirectional_path_container.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace path_extend {
+
+//Single edge seeds for path extension. Seeds are kept as plain edge ids,
+//a BidirectionalPath is created only when extension actually grows a seed.
+class SeedContainer {
+    typedef debruijn_graph::Graph Graph;
+    typedef debruijn_graph::EdgeId EdgeId;
+
+    std::vector<EdgeId> edges_;
+
+public:
+    typedef std::vector<EdgeId>::const_iterator const_iterator;
+
+    SeedContainer() = default;
+
+    explicit SeedContainer(std::vector<EdgeId> edges)
+            : edges_(std::move(edges)) {}
+
+    size_t size() const { return edges_.size(); }
+    bool empty() const { return edges_.empty(); }
+
+    EdgeId operator[](size_t i) const { return edges_[i]; }
+
+    const_iterator begin() const { return edges_.begin(); }
+    const_iterator end() const { return edges_.end(); }
+
+    //Same order as PathContainer::SortByLength gives for single edge paths
+    void SortByLength(const Graph &g, bool desc = true) {
+        std::stable_sort(edges_.begin(), edges_.end(), [&](EdgeId e1, EdgeId e2) {
+            if (g.length(e1) != g.length(e2))
+                return desc ? g.length(e1) > g.length(e2) : g.length(e1) < g.length(e2);
+            return g.int_id(e1) < g.int_id(e2);
+        });
+    }
+
+    //Materializes all the seeds, meant for debug output only
+    PathContainer ToPaths(const Graph &g) const {
+        PathContainer paths;
+        paths.reserve(edges_.size());
+        for (EdgeId e : edges_)
+            paths.Create(g, e);
+        return paths;
+    }
+};
+
+}
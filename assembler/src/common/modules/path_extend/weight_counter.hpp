@@ -125,6 +125,9 @@ public:
     }
 };
 
+//Counters are immutable after construction and safe to call concurrently. Paired info
+//prefetched for an extension step lives in a PairedInfoCache owned by the caller,
+//a cache must not be shared between threads.
 class WeightCounter {
 
 protected:
@@ -145,29 +148,61 @@ public:
 
     virtual ~WeightCounter() = default;
 
+    //With a cache given, the paired info is fetched through it and can be reused for the same step
     virtual std::set<size_t> PairInfoExist(const BidirectionalPath &path, EdgeId e,
-                                           int gap = 0) const = 0;
+                                           int gap = 0, PairedInfoCache *cache = nullptr) const = 0;
 
     virtual double CountWeight(const BidirectionalPath &path, EdgeId e,
                                const std::set<size_t> &excluded_edges = {}, int gapLength = 0) const = 0;
 
+    //Weights of the candidates of a single extension step. Paired info for all
+    //(path edge, candidate) pairs is fetched into the cache in one batch first.
+    virtual std::vector<double> CountWeights(const BidirectionalPath &path, const std::vector<EdgeId> &candidates,
+                                             PairedInfoCache &cache,
+                                             const std::set<size_t> &excluded_edges = {}, int gap = 0) const = 0;
+
     const PairedInfoLibrary& PairedLibrary() const {
         return *lib_;
     }
 
 protected:
+    //Ideally covered path edges of every candidate, their paired info is prefetched into the cache
+    std::vector<std::vector<EdgeWithPairedInfo>> FetchCoveredEdges(const BidirectionalPath &path,
+                                                                   const std::vector<EdgeId> &candidates,
+                                                                   int gap, PairedInfoCache &cache) const {
+        std::vector<std::vector<EdgeWithPairedInfo>> covered;
+        std::vector<PairedInfoCache::EdgePair> pairs;
+        covered.reserve(candidates.size());
+        for (EdgeId e : candidates) {
+            covered.push_back(ideal_provider_->FindCoveredEdges(path, e, gap));
+            for (const auto& e_w_pi : covered.back())
+                pairs.emplace_back(path[e_w_pi.e_], e);
+        }
+
+        cache.Fetch(*lib_, std::move(pairs));
+        return covered;
+    }
+
+    //Without the cache the index is queried directly
+    double CountPairedInfo(EdgeId e1, EdgeId e2, int distance, const PairedInfoCache *cache) const {
+        if (!cache)
+            return lib_->CountPairedInfo(e1, e2, distance);
+        return lib_->CountPairedInfo(cache->Get(e1, e2), distance);
+    }
+
     DECL_LOGGER("WeightCounter");
 };
 
 class ReadCountWeightCounter: public WeightCounter {
 
     std::vector<EdgeWithPairedInfo> CountLib(const BidirectionalPath &path, EdgeId e,
-                                             int add_gap = 0) const {
+                                             const std::vector<EdgeWithPairedInfo> &ideally_covered_edges,
+                                             int add_gap, const PairedInfoCache *cache) const {
         std::vector<EdgeWithPairedInfo> answer;
 
-        for (const EdgeWithPairedInfo& e_w_pi : ideal_provider_->FindCoveredEdges(path, e, add_gap)) {
-            double w = lib_->CountPairedInfo(path[e_w_pi.e_], e,
-                    (int) path.LengthAt(e_w_pi.e_) + add_gap);
+        for (const EdgeWithPairedInfo& e_w_pi : ideally_covered_edges) {
+            double w = CountPairedInfo(path[e_w_pi.e_], e,
+                    (int) path.LengthAt(e_w_pi.e_) + add_gap, cache);
 
             if (normalize_weight_) {
                 w /= e_w_pi.pi_;
@@ -178,6 +213,20 @@ class ReadCountWeightCounter: public WeightCounter {
         return answer;
     }
 
+    double CountWeight(const BidirectionalPath &path, EdgeId e,
+                       const std::vector<EdgeWithPairedInfo> &ideally_covered_edges,
+                       const std::set<size_t> &excluded_edges, int gap, const PairedInfoCache *cache) const {
+        double weight = 0.0;
+
+        for (const auto& e_w_pi : CountLib(path, e, ideally_covered_edges, gap, cache)) {
+            if (!excluded_edges.count(e_w_pi.e_)) {
+                weight += e_w_pi.pi_;
+            }
+        }
+
+        return weight;
+    }
+
 public:
 
     ReadCountWeightCounter(const Graph &g, const std::shared_ptr<PairedInfoLibrary> &lib,
@@ -188,21 +237,28 @@ public:
 
     double CountWeight(const BidirectionalPath &path, EdgeId e,
                        const std::set<size_t> &excluded_edges, int gap) const override {
-        double weight = 0.0;
+        return CountWeight(path, e, ideal_provider_->FindCoveredEdges(path, e, gap), excluded_edges, gap, nullptr);
+    }
 
-        for (const auto& e_w_pi : CountLib(path, e, gap)) {
-            if (!excluded_edges.count(e_w_pi.e_)) {
-                weight += e_w_pi.pi_;
-            }
-        }
+    std::vector<double> CountWeights(const BidirectionalPath &path, const std::vector<EdgeId> &candidates,
+                                     PairedInfoCache &cache,
+                                     const std::set<size_t> &excluded_edges, int gap) const override {
+        const auto covered = FetchCoveredEdges(path, candidates, gap, cache);
 
-        return weight;
+        std::vector<double> weights;
+        weights.reserve(candidates.size());
+        for (size_t i = 0; i < candidates.size(); ++i)
+            weights.push_back(CountWeight(path, candidates[i], covered[i], excluded_edges, gap, &cache));
+        return weights;
     }
 
     std::set<size_t> PairInfoExist(const BidirectionalPath &path, EdgeId e,
-                                   int gap = 0) const override {
+                                   int gap = 0, PairedInfoCache *cache = nullptr) const override {
+        const auto covered = cache ? FetchCoveredEdges(path, {e}, gap, *cache).front()
+                                   : ideal_provider_->FindCoveredEdges(path, e, gap);
+
         std::set<size_t> answer;
-        for (const auto& e_w_pi : CountLib(path, e, gap)) {
+        for (const auto& e_w_pi : CountLib(path, e, covered, gap, cache)) {
             if (math::gr(e_w_pi.pi_, 0.)) {
                 answer.insert(e_w_pi.e_);
             }
@@ -231,7 +287,7 @@ class PathCoverWeightCounter: public WeightCounter {
 
     std::vector<EdgeWithPairedInfo> CountLib(const BidirectionalPath &path, EdgeId e,
                                              const std::vector<EdgeWithPairedInfo> &ideally_covered_edges,
-                                             int add_gap = 0) const {
+                                             int add_gap, const PairedInfoCache *cache) const {
         std::vector<EdgeWithPairedInfo> answer;
 
         for (const auto& e_w_pi : ideally_covered_edges) {
@@ -244,8 +300,8 @@ class PathCoverWeightCounter: public WeightCounter {
                                                        << " " << g_.str(e) << " at dist "
                                                        << (path.LengthAt(e_w_pi.e_) + add_gap));
 
-            double weight = lib_->CountPairedInfo(path[e_w_pi.e_], e,
-                    (int) path.LengthAt(e_w_pi.e_) + add_gap);
+            double weight = CountPairedInfo(path[e_w_pi.e_], e,
+                    (int) path.LengthAt(e_w_pi.e_) + add_gap, cache);
 
             TRACE("Actual weight " << weight);
 
@@ -263,24 +319,13 @@ class PathCoverWeightCounter: public WeightCounter {
         return answer;
     }
 
-public:
-
-    PathCoverWeightCounter(const Graph &g, const std::shared_ptr<PairedInfoLibrary> &lib,
-                           bool normalize_weight,
-                           double single_threshold,
-                           std::shared_ptr<IdealInfoProvider> ideal_provider = nullptr) :
-            WeightCounter(g, lib, normalize_weight, ideal_provider),
-            single_threshold_(single_threshold) {
-        CHECK_FATAL_ERROR(math::gr(single_threshold_, 0.), "Threshold value not initialized");
-    }
-
     double CountWeight(const BidirectionalPath &path, EdgeId e,
-                       const std::set<size_t> &excluded_edges, int gap) const override {
+                       const std::vector<EdgeWithPairedInfo> &ideal_coverage,
+                       const std::set<size_t> &excluded_edges, int gap, const PairedInfoCache *cache) const {
         TRACE("Counting weight for edge " << g_.str(e));
         double lib_weight = 0.;
-        const auto ideal_coverage = ideal_provider_->FindCoveredEdges(path, e, gap);
 
-        for (const auto& e_w_pi : CountLib(path, e, ideal_coverage, gap)) {
+        for (const auto& e_w_pi : CountLib(path, e, ideal_coverage, gap, cache)) {
             if (!excluded_edges.count(e_w_pi.e_)) {
                 lib_weight += e_w_pi.pi_;
             }
@@ -295,10 +340,41 @@ public:
         return math::eq(total_ideal_coverage, 0.) ? 0. : lib_weight / total_ideal_coverage;
     }
 
+public:
+
+    PathCoverWeightCounter(const Graph &g, const std::shared_ptr<PairedInfoLibrary> &lib,
+                           bool normalize_weight,
+                           double single_threshold,
+                           std::shared_ptr<IdealInfoProvider> ideal_provider = nullptr) :
+            WeightCounter(g, lib, normalize_weight, ideal_provider),
+            single_threshold_(single_threshold) {
+        CHECK_FATAL_ERROR(math::gr(single_threshold_, 0.), "Threshold value not initialized");
+    }
+
+    double CountWeight(const BidirectionalPath &path, EdgeId e,
+                       const std::set<size_t> &excluded_edges, int gap) const override {
+        return CountWeight(path, e, ideal_provider_->FindCoveredEdges(path, e, gap), excluded_edges, gap, nullptr);
+    }
+
+    std::vector<double> CountWeights(const BidirectionalPath &path, const std::vector<EdgeId> &candidates,
+                                     PairedInfoCache &cache,
+                                     const std::set<size_t> &excluded_edges, int gap) const override {
+        const auto covered = FetchCoveredEdges(path, candidates, gap, cache);
+
+        std::vector<double> weights;
+        weights.reserve(candidates.size());
+        for (size_t i = 0; i < candidates.size(); ++i)
+            weights.push_back(CountWeight(path, candidates[i], covered[i], excluded_edges, gap, &cache));
+        return weights;
+    }
+
     std::set<size_t> PairInfoExist(const BidirectionalPath& path, EdgeId e, 
-                                    int gap = 0) const override {
+                                    int gap = 0, PairedInfoCache *cache = nullptr) const override {
+        const auto covered = cache ? FetchCoveredEdges(path, {e}, gap, *cache).front()
+                                   : ideal_provider_->FindCoveredEdges(path, e, gap);
+
         std::set<size_t> answer;
-        for (const auto& e_w_pi : CountLib(path, e, ideal_provider_->FindCoveredEdges(path, e, gap), gap)) {
+        for (const auto& e_w_pi : CountLib(path, e, covered, gap, cache)) {
             if (math::gr(e_w_pi.pi_, 0.)) {
                 answer.insert(e_w_pi.e_);
             }
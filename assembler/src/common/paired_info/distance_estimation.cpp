@@ -15,37 +15,59 @@ std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, Edg
 }
 
 void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
-    std::vector<size_t> path_lower_bounds;
+    Cache cache;
+    FillGraphDistancesLengths(e1, second_edges, cache);
+}
+
+const GraphDistanceFinder::GraphLengths &GraphDistanceFinder::RawDistancesLengths(VertexId start, VertexId end,
+                                                                                 Cache &cache) const {
     size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
-    PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound);
+    if (!cache.paths_proc_ || cache.start_ != start || cache.length_bound_ != path_upper_bound) {
+        cache.start_ = start;
+        cache.length_bound_ = path_upper_bound;
+        cache.paths_proc_.reset(new PathProcessor<Graph>(graph_, start, path_upper_bound));
+        cache.lengths_.clear();
+    }
+
+    auto it = cache.lengths_.find(end);
+    if (it != cache.lengths_.end())
+        return it->second;
+
+    // Lower bound only filters the reported paths and does not prune the traversal,
+    // so we collect everything once and filter per edge pair afterwards
+    DistancesLengthsCallback<Graph> callback(graph_);
+    cache.paths_proc_->Process(end, 0, path_upper_bound, callback);
+    return cache.lengths_.emplace(end, callback.distances()).first->second;
+}
 
+void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges, Cache &cache) const {
     for (auto &entry : second_edges) {
         EdgeId e2 = entry.first;
         size_t path_lower_bound = PairInfoPathLengthLowerBound(graph_.k(), graph_.length(e1),
                                                                graph_.length(e2), gap_, delta_);
 
-        TRACE("Bounds for paths are " << path_lower_bound << " " << path_upper_bound);
+        TRACE("Lower bound for paths is " << path_lower_bound);
 
-        DistancesLengthsCallback<Graph> callback(graph_);
-        paths_proc.Process(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, callback);
-        GraphLengths lengths = callback.distances();
-        for (size_t j = 0; j < lengths.size(); ++j) {
-            lengths[j] += graph_.length(e1);
+        const GraphLengths &raw_lengths = RawDistancesLengths(graph_.EdgeEnd(e1), graph_.EdgeStart(e2), cache);
+        // raw lengths are sorted, so are the resulting ones
+        GraphLengths lengths;
+        if (e1 == e2)
+            lengths.push_back(0);
+        for (auto it = std::lower_bound(raw_lengths.begin(), raw_lengths.end(), path_lower_bound);
+             it != raw_lengths.end(); ++it) {
+            lengths.push_back(*it + graph_.length(e1));
             TRACE("Resulting distance set for " <<
                                                 " edge " << graph_.int_id(e2) <<
-                                                " #" << j << " length " << lengths[j]);
+                                                " #" << lengths.size() - 1 << " length " << lengths.back());
         }
 
-        if (e1 == e2)
-            lengths.push_back(0);
-
-        std::sort(lengths.begin(), lengths.end());
-        entry.second = lengths;
+        entry.second = std::move(lengths);
     }
 }
 
-void AbstractDistanceEstimator::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
-    distance_finder_.FillGraphDistancesLengths(e1, second_edges);
+void AbstractDistanceEstimator::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges,
+                                                          GraphDistanceFinder::Cache &cache) const {
+    distance_finder_.FillGraphDistancesLengths(e1, second_edges, cache);
 }
 
 AbstractDistanceEstimator::OutHistogram AbstractDistanceEstimator::ClusterResult(EdgePair,
@@ -76,16 +98,21 @@ void DistanceEstimator::Estimate(PairedInfoIndexT<Graph> &result, size_t nthread
     const auto &index = this->index();
 
     DEBUG("Collecting edge infos");
+    // Edges ending at the same vertex go one after another, so they are likely
+    // to be processed by the same thread and share the cached traversals
     std::vector<EdgeId> edges;
-    for (auto it = this->graph().ConstEdgeBegin(); !it.IsEnd(); ++it)
-        edges.push_back(*it);
+    for (VertexId v : this->graph().vertices())
+        for (EdgeId e : this->graph().IncomingEdges(v))
+            edges.push_back(e);
 
     DEBUG("Processing");
     PairedInfoBuffersT<Graph> buffer(this->graph(), nthreads);
+    std::vector<GraphDistanceFinder::Cache> caches(nthreads);
 #   pragma omp parallel for num_threads(nthreads) schedule(guided, 10)
     for (size_t i = 0; i < edges.size(); ++i) {
         EdgeId edge = edges[i];
-        ProcessEdge(edge, index, buffer[omp_get_thread_num()]);
+        size_t thread = omp_get_thread_num();
+        ProcessEdge(edge, index, caches[thread], buffer[thread]);
     }
 
     for (size_t i = 0; i < nthreads; ++i) {
@@ -149,13 +176,15 @@ DistanceEstimator::EstimHist DistanceEstimator::EstimateEdgePairDistances(EdgePa
     return result;
 }
 
-void DistanceEstimator::ProcessEdge(EdgeId e1, const InPairedIndex &pi, PairedInfoBuffer<Graph> &result) const {
+void DistanceEstimator::ProcessEdge(EdgeId e1, const InPairedIndex &pi,
+                                    GraphDistanceFinder::Cache &cache,
+                                    PairedInfoBuffer<Graph> &result) const {
     typename base::LengthMap second_edges;
     auto inner_map = pi.GetHalf(e1);
     for (auto i : inner_map)
         second_edges[i.first];
 
-    this->FillGraphDistancesLengths(e1, second_edges);
+    this->FillGraphDistancesLengths(e1, second_edges, cache);
 
     for (const auto &entry: second_edges) {
         EdgeId e2 = entry.first;
@@ -28,6 +28,18 @@ class GraphDistanceFinder {
     typedef std::map<debruijn_graph::EdgeId, GraphLengths> LengthMap;
 
 public:
+    // Keeps the bounded Dijkstra run and the raw path lengths for the last start vertex,
+    // so all edges ending at the same vertex share one traversal. Not thread-safe,
+    // use one instance per thread.
+    class Cache {
+        friend class GraphDistanceFinder;
+
+        debruijn_graph::VertexId start_;
+        size_t length_bound_ = 0;
+        std::unique_ptr<PathProcessor<debruijn_graph::Graph>> paths_proc_;
+        std::unordered_map<debruijn_graph::VertexId, GraphLengths> lengths_;
+    };
+
     GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta) :
             graph_(graph), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
             delta_((double) delta) { }
@@ -37,7 +49,13 @@ public:
     // finds all distances from a current edge to a set of edges
     void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
 
+    // same as above, but reuses the traversals stored in cache
+    void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges, Cache &cache) const;
+
 private:
+    const GraphLengths &RawDistancesLengths(debruijn_graph::VertexId start, debruijn_graph::VertexId end,
+                                            Cache &cache) const;
+
     DECL_LOGGER("GraphDistanceFinder");
     const debruijn_graph::Graph &graph_;
     const size_t insert_size_;
@@ -74,7 +92,8 @@ protected:
 
     const InPairedIndex &index() const { return index_; }
 
-    void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
+    void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges,
+                                   GraphDistanceFinder::Cache &cache) const;
 
     OutHistogram ClusterResult(EdgePair /*ep*/, const EstimHist &estimated) const;
 
@@ -128,6 +147,7 @@ protected:
 private:
     virtual void ProcessEdge(debruijn_graph::EdgeId e1,
                              const InPairedIndex &pi,
+                             GraphDistanceFinder::Cache &cache,
                              PairedInfoBuffer<debruijn_graph::Graph> &result) const;
 
     virtual const std::string Name() const {
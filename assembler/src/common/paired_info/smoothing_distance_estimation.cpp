@@ -76,13 +76,14 @@ SmoothingDistanceEstimator::EstimHist SmoothingDistanceEstimator::FindEdgePairDi
 }
 
 void SmoothingDistanceEstimator::ProcessEdge(EdgeId e1, const InPairedIndex &pi,
+                                             GraphDistanceFinder::Cache &cache,
                                              PairedInfoBuffer<Graph> &result) const {
     typename base::LengthMap second_edges;
     auto inner_map = pi.GetHalf(e1);
     for (auto I : inner_map)
         second_edges[I.first];
 
-    this->FillGraphDistancesLengths(e1, second_edges);
+    this->FillGraphDistancesLengths(e1, second_edges, cache);
 
     for (const auto &entry: second_edges) {
         EdgeId e2 = entry.first;
@@ -82,6 +82,7 @@ private:
 
     void ProcessEdge(debruijn_graph::EdgeId e1,
                      const InPairedIndex &pi,
+                     GraphDistanceFinder::Cache &cache,
                      PairedInfoBuffer<debruijn_graph::Graph> &result) const override;
 
     bool IsTipTip(debruijn_graph::EdgeId e1, debruijn_graph::EdgeId e2) const;
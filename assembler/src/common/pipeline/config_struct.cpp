@@ -752,6 +752,7 @@ void load_launch_info(debruijn_config &cfg, boost::property_tree::ptree const &p
     cfg.max_threads = spades_set_omp_threads(cfg.max_threads);
 
     load(cfg.max_memory, pt, "max_memory");
+    load(cfg.compact_sequences, pt, "compact_sequences", false);
 
     fs::CheckFileExistenceFATAL(cfg.dataset_file);
     boost::property_tree::ptree ds_pt;
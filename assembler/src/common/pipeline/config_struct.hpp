@@ -517,6 +517,7 @@ struct debruijn_config {
 
     unsigned max_threads;
     size_t max_memory;
+    bool compact_sequences;
 
     resolving_mode rm;
     path_extend::pe_config::MainPEParamsT pe_params;
@@ -549,7 +550,8 @@ struct debruijn_config {
     bool need_mapping;
 
     debruijn_config() :
-            use_single_reads(false) {
+            use_single_reads(false),
+            compact_sequences(false) {
 
     }
 };
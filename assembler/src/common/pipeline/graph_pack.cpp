@@ -140,7 +140,10 @@ void GraphPack::DetachAll() {
 }
 
 void GraphPack::PrepareForStage(const char*) {
-    get_mutable<Graph>().clear_state();
+    Graph &g = get_mutable<Graph>();
+    g.clear_state();
+    if (g.sequence_arena_enabled())
+        g.CompactSequences();
 }
 
 
@@ -0,0 +1,117 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "resource_report.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+
+namespace spades {
+
+ResourceReport::Scope::Scope(ResourceReport *report, std::string id, std::string name, bool phase)
+        : report_(report), id_(std::move(id)), name_(std::move(name)), phase_(phase) {
+    if (!report_)
+        return;
+
+    start_items_ = utils::counted_items();
+    start_ = report_->OpenScope();
+}
+
+ResourceReport::Scope::~Scope() {
+    if (!report_)
+        return;
+
+    auto end = utils::resource_usage::current();
+    size_t peak_rss = report_->CloseScope(end);
+    Entry entry{std::move(id_), std::move(name_), phase_, unsigned(omp_get_max_threads()),
+                start_, end, peak_rss, {}};
+    for (const auto &item : utils::counted_items()) {
+        auto it = start_items_.find(item.first);
+        size_t delta = item.second - (it == start_items_.end() ? 0 : it->second);
+        if (delta)
+            entry.items.emplace(item.first, delta);
+    }
+
+    report_->entries_.push_back(std::move(entry));
+    if (!phase_)
+        report_->Write();
+}
+
+void ResourceReport::UpdatePeaks(const utils::resource_usage &usage) {
+    size_t peak = peak_reset_ ? std::max(usage.peak_rss, usage.rss) : usage.rss;
+    for (size_t &open_peak : open_peaks_)
+        open_peak = std::max(open_peak, peak);
+}
+
+utils::resource_usage ResourceReport::OpenScope() {
+    UpdatePeaks(utils::resource_usage::current());
+    peak_reset_ = peak_reset_ && utils::reset_peak_rss();
+    open_peaks_.push_back(0);
+
+    auto usage = utils::resource_usage::current();
+    UpdatePeaks(usage);
+    return usage;
+}
+
+size_t ResourceReport::CloseScope(const utils::resource_usage &usage) {
+    VERIFY(!open_peaks_.empty());
+    UpdatePeaks(usage);
+    size_t peak = open_peaks_.back();
+    open_peaks_.pop_back();
+    return peak;
+}
+
+void ResourceReport::Write() const {
+    std::error_code ec;
+    llvm::raw_fd_ostream os(filename_, ec);
+    if (ec) {
+        WARN("Failed to write resource report to " << filename_ << ": " << ec.message());
+        return;
+    }
+
+    llvm::json::OStream json(os, 2);
+    json.object([&] {
+        json.attribute("peak_rss_source", peak_reset_ ? "VmHWM" : "scope boundaries");
+        json.attributeArray("entries", [&] {
+            for (const Entry &e : entries_) {
+                double wall = e.end.wall_time - e.start.wall_time;
+                double cpu = e.end.cpu_time - e.start.cpu_time;
+                json.object([&] {
+                    json.attribute("id", e.id);
+                    json.attribute("name", e.name);
+                    json.attribute("type", e.phase ? "phase" : "stage");
+                    json.attribute("wall_time", wall);
+                    json.attribute("cpu_time", cpu);
+                    json.attribute("threads", int64_t(e.threads));
+                    json.attribute("thread_utilization",
+                                   wall > 0 ? cpu / (wall * e.threads) : 0.);
+                    json.attribute("peak_rss_kb", int64_t(e.peak_rss));
+                    json.attribute("rss_kb", int64_t(e.end.rss));
+                    json.attribute("rss_delta_kb", int64_t(e.end.rss) - int64_t(e.start.rss));
+                    json.attribute("read_chars", int64_t(e.end.read_chars - e.start.read_chars));
+                    json.attribute("written_chars", int64_t(e.end.written_chars - e.start.written_chars));
+                    json.attribute("read_bytes", int64_t(e.end.read_bytes - e.start.read_bytes));
+                    json.attribute("written_bytes", int64_t(e.end.written_bytes - e.start.written_bytes));
+                    json.attributeObject("items", [&] {
+                        for (const auto &item : e.items) {
+                            json.attribute(item.first, int64_t(item.second));
+                            json.attribute(item.first + "_per_sec",
+                                           wall > 0 ? double(item.second) / wall : 0.);
+                        }
+                    });
+                });
+            }
+        });
+    });
+}
+
+}
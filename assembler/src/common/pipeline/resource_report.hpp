@@ -0,0 +1,71 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/perf/resource_usage.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace spades {
+
+// Machine-readable per-stage / per-phase resource consumption report (JSON)
+class ResourceReport {
+public:
+    explicit ResourceReport(std::string filename)
+            : filename_(std::move(filename)) {}
+
+    // Records the resources consumed between construction and destruction
+    class Scope {
+    public:
+        Scope(ResourceReport *report, std::string id, std::string name, bool phase);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        ResourceReport *report_;
+        std::string id_;
+        std::string name_;
+        bool phase_;
+        utils::resource_usage start_;
+        std::map<std::string, size_t> start_items_;
+    };
+
+    const std::string &filename() const { return filename_; }
+
+    // The file is rewritten as a whole, so the report is valid after every stage
+    void Write() const;
+
+private:
+    struct Entry {
+        std::string id;
+        std::string name;
+        bool phase;
+        unsigned threads;
+        utils::resource_usage start;
+        utils::resource_usage end;
+        size_t peak_rss;
+        std::map<std::string, size_t> items;
+    };
+
+    // The kernel high-water mark is restarted for every scope, the peaks
+    // reached so far are kept for the enclosing scopes
+    utils::resource_usage OpenScope();
+    size_t CloseScope(const utils::resource_usage &usage);
+    void UpdatePeaks(const utils::resource_usage &usage);
+
+    std::string filename_;
+    std::vector<Entry> entries_;
+    std::vector<size_t> open_peaks_;
+    // Without the reset only the RSS sampled at scope boundaries is available
+    bool peak_reset_ = true;
+};
+
+}
@@ -117,6 +117,8 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
         INFO("PROCEDURE == " << phase->name() << " (id: " << id() << ":" << phase->id() << ")");
         {
             TIME_TRACE_SCOPE(phase->name());
+            ResourceReport::Scope resources(parent_->resource_report(),
+                                            std::string(id()) + ":" + phase->id(), phase->name(), true);
             phase->run(gp, started_from);
         }
 
@@ -183,10 +185,13 @@ void StageManager::run(debruijn_graph::GraphPack& g,
         AssemblyStage *stage = start_stage->get();
 
         INFO("STAGE == " << stage->name() << " (id: " << stage->id() << ")");
-        stage->prepare(g, start_from);        
         {
-            TIME_TRACE_SCOPE(stage->name());
-            stage->run(g, start_from);
+            ResourceReport::Scope resources(resource_report(), stage->id(), stage->name(), false);
+            stage->prepare(g, start_from);
+            {
+                TIME_TRACE_SCOPE(stage->name());
+                stage->run(g, start_from);
+            }
         }
 
         if (saves_policy_.EnabledCheckpoints() != SavesPolicy::Checkpoints::None) {
@@ -10,6 +10,7 @@
 
 #include "pipeline/graph_pack.hpp"
 #include "pipeline/config_struct.hpp"
+#include "pipeline/resource_report.hpp"
 
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/logger/logger.hpp"
@@ -218,11 +219,21 @@ public:
         return saves_policy_;
     }
 
+    // Per-stage and per-phase resource consumption is written to filename in JSON
+    void enable_resource_report(const std::string &filename) {
+        report_.reset(new ResourceReport(filename));
+    }
+
+    ResourceReport *resource_report() const {
+        return report_.get();
+    }
+
 private:
     using Stages = std::vector<std::unique_ptr<AssemblyStage> >;
 
     Stages stages_;
     SavesPolicy saves_policy_;
+    std::unique_ptr<ResourceReport> report_;
 
     DECL_LOGGER("StageManager");
 };
@@ -0,0 +1,116 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Slab allocator for nucleotide buffers of Sequence. Allocation is a single
+ * atomic bump of the current slab. Every allocation is prefixed with the
+ * pointer to its slab, each slab counts its live allocations and is returned
+ * to the system once the arena and all allocations from it are gone. So the
+ * buffers might safely outlive the arena itself.
+ */
+class NuclArena {
+    struct Slab {
+        std::atomic<size_t> refs;
+        std::atomic<size_t> used;
+        size_t capacity;
+
+        explicit Slab(size_t cap)
+                : refs(1), used(0), capacity(cap) {}
+
+        char *data() { return reinterpret_cast<char*>(this + 1); }
+
+        void Release() {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->~Slab();
+                free(this);
+            }
+        }
+    };
+
+    static_assert(sizeof(Slab) % alignof(uint64_t) == 0, "Slab header breaks the alignment");
+
+  public:
+    static constexpr size_t DEFAULT_SLAB_SIZE = 32 * 1024 * 1024;
+
+    explicit NuclArena(size_t slab_size = DEFAULT_SLAB_SIZE)
+            : slab_size_(slab_size), current_(nullptr) {}
+
+    NuclArena(const NuclArena &) = delete;
+    NuclArena &operator=(const NuclArena &) = delete;
+
+    ~NuclArena() {
+        for (Slab *slab : slabs_)
+            slab->Release();
+    }
+
+    // Thread-safe
+    void *Allocate(size_t bytes) {
+        size_t chunk = sizeof(Slab*) + ((bytes + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1));
+        while (true) {
+            Slab *slab = current_.load(std::memory_order_acquire);
+            if (slab) {
+                size_t offset = slab->used.fetch_add(chunk, std::memory_order_relaxed);
+                if (offset + chunk <= slab->capacity) {
+                    slab->refs.fetch_add(1, std::memory_order_relaxed);
+                    char *mem = slab->data() + offset;
+                    *reinterpret_cast<Slab**>(mem) = slab;
+                    return mem + sizeof(Slab*);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (current_.load(std::memory_order_relaxed) != slab)
+                continue;
+
+            size_t capacity = std::max(slab_size_, chunk);
+            void *mem = malloc(sizeof(Slab) + capacity);
+            VERIFY_MSG(mem, "Failed to allocate nucleotide arena slab");
+            Slab *fresh = new (mem) Slab(capacity);
+            slabs_.push_back(fresh);
+            current_.store(fresh, std::memory_order_release);
+        }
+    }
+
+    // Might be called after the arena is destroyed
+    static void Deallocate(void *p) {
+        // Slab pointer precedes the allocation. Integer arithmetic keeps GCC from
+        // reporting -Warray-bounds when inlined next to non-arena allocations
+        uintptr_t header = reinterpret_cast<uintptr_t>(p) - sizeof(Slab*);
+        Slab *slab = *reinterpret_cast<Slab**>(header);
+        slab->Release();
+    }
+
+    size_t slabs() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return slabs_.size();
+    }
+
+    size_t capacity() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t res = 0;
+        for (const Slab *slab : slabs_)
+            res += slab->capacity;
+        return res;
+    }
+
+  private:
+    size_t slab_size_;
+    std::atomic<Slab*> current_;
+    std::vector<Slab*> slabs_;
+    mutable std::mutex mutex_;
+};
@@ -11,9 +11,12 @@
 #include <string>
 #include <memory>
 #include <cstring>
+#include <atomic>
+#include <type_traits>
 
 #include "seq.hpp"
 #include "rtseq.hpp"
+#include "nucl_arena.hpp"
 
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/Support/TrailingObjects.h>
@@ -32,19 +35,23 @@ class Sequence {
     // Number of bits in STN (for faster div and mod)
     const static size_t STNBits = log_<STN, 2>::value;
 
-    class ManagedNuclBuffer final : public llvm::ThreadSafeRefCountedBase<ManagedNuclBuffer>,
-                                    protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
+    class ManagedNuclBuffer final : protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
         friend TrailingObjects;
 
-        ManagedNuclBuffer() {}
+        // Occupies the same space as the refcount of llvm::ThreadSafeRefCountedBase
+        // (the trailing data is 8-byte aligned anyway), but also tells how to free the buffer
+        mutable std::atomic<uint32_t> ref_cnt_;
+        bool in_arena_;
 
-        ManagedNuclBuffer(size_t nucls, ST *buf) {
+        explicit ManagedNuclBuffer(bool in_arena = false)
+                : ref_cnt_(0), in_arena_(in_arena) {}
+
+        ManagedNuclBuffer(size_t nucls, ST *buf)
+                : ManagedNuclBuffer() {
             std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data());
         }
 
       public:
-        void operator delete(void *p) { ::operator delete(p); }
-
         static ManagedNuclBuffer *create(size_t nucls) {
             void *mem = ::operator new(totalSizeToAlloc<ST>(Sequence::DataSize(nucls)));
             return new (mem) ManagedNuclBuffer();
@@ -55,6 +62,26 @@ class Sequence {
             return new (mem) ManagedNuclBuffer(nucls, data);
         }
 
+        static ManagedNuclBuffer *create(size_t nucls, NuclArena &arena) {
+            void *mem = arena.Allocate(totalSizeToAlloc<ST>(Sequence::DataSize(nucls)));
+            return new (mem) ManagedNuclBuffer(true);
+        }
+
+        void Retain() const { ref_cnt_.fetch_add(1, std::memory_order_relaxed); }
+
+        void Release() const {
+            if (ref_cnt_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            static_assert(std::is_trivially_destructible<ManagedNuclBuffer>::value,
+                          "ManagedNuclBuffer is freed without calling the destructor");
+            void *mem = const_cast<ManagedNuclBuffer*>(this);
+            if (in_arena_)
+                NuclArena::Deallocate(mem);
+            else
+                ::operator delete(mem);
+        }
+
         const ST *data() const { return getTrailingObjects<ST>(); }
         ST *data() { return getTrailingObjects<ST>(); }
     };
@@ -121,6 +148,24 @@ class Sequence {
             bytes[cur] = 0;
     }
 
+    // Copies nucleotides [s.from_, s.from_ + s.size_) of the underlying storage
+    void CopyNucls(const Sequence &s) {
+        const ST *src = s.data_->data();
+        ST *dst = data_->data();
+        size_t words = DataSize(size_), src_words = DataSize(s.from_ + s.size_);
+        size_t first = s.from_ >> STNBits, shift = (s.from_ & (STN - 1)) << 1;
+        for (size_t i = 0; i < words; ++i) {
+            ST w = src[first + i] >> shift;
+            if (shift && first + i + 1 < src_words)
+                w |= src[first + i + 1] << (STBits - shift);
+            dst[i] = w;
+        }
+
+        // Keep the tail zeroed as InitFromNucls() does
+        if (size_t rem = size_ & (STN - 1))
+            dst[words - 1] &= (ST(1) << (rem << 1)) - 1;
+    }
+
     inline bool ReadHeader(std::istream &file);
     inline bool WriteHeader(std::ostream &file) const;
 
@@ -173,6 +218,16 @@ public:
     Sequence(const Sequence &s)
             : Sequence(s, s.from_, s.size_, s.rtl_) {}
 
+    /**
+     * Copies the sequence into a tightly sized buffer allocated from the arena.
+     * Orientation of the storage is preserved, so the copy of the conjugate is
+     * just !copy and may share the buffer.
+     */
+    Sequence(const Sequence &s, NuclArena &arena)
+            : size_(s.size_), from_(0), rtl_(s.rtl_), data_(ManagedNuclBuffer::create(s.size_, arena)) {
+        CopyNucls(s);
+    }
+
     const Sequence &operator=(const Sequence &rhs) {
         if (&rhs == this)
             return *this;
@@ -10,6 +10,7 @@
 #include "kmer_splitter.hpp"
 #include "io/reads/io_helper.hpp"
 #include "adt/iterator_range.hpp"
+#include "utils/perf/resource_usage.hpp"
 
 namespace utils {
 
@@ -73,7 +74,7 @@ class DeBruijnReadKMerSplitter : public DeBruijnKMerSplitter<KmerFilter> {
 
   template<class ReadStream>
   size_t
-  FillBufferFromStream(ReadStream& stream, unsigned thread_id);
+  FillBufferFromStream(ReadStream& stream, unsigned thread_id, size_t &kmers);
 
  public:
   using typename DeBruijnKMerSplitter<KmerFilter>::RawKMers;
@@ -91,13 +92,16 @@ class DeBruijnReadKMerSplitter : public DeBruijnKMerSplitter<KmerFilter> {
 template<class Read, class KmerFilter> template<class ReadStream>
 size_t
 DeBruijnReadKMerSplitter< Read, KmerFilter>::FillBufferFromStream(ReadStream &stream,
-                                                                  unsigned thread_id) {
+                                                                  unsigned thread_id,
+                                                                  size_t &kmers) {
   typename ReadStream::ReadT r;
   size_t reads = 0;
 
   while (!stream.eof()) {
     stream >> r;
     reads += 1;
+    if (r.size() >= this->K_)
+      kmers += r.size() - this->K_ + 1;
 
     if (this->FillBufferFromSequence(r.sequence(), thread_id))
       break;
@@ -111,12 +115,12 @@ typename DeBruijnReadKMerSplitter<Read, KmerFilter>::RawKMers
 DeBruijnReadKMerSplitter<Read, KmerFilter>::Split(size_t num_files, unsigned nthreads) {
   auto out = this->PrepareBuffers(num_files, nthreads, this->read_buffer_size_);
 
-  size_t counter = 0, n = 15;
+  size_t counter = 0, kmers = 0, n = 15;
   streams_.reset();
   while (!streams_.eof()) {
-#   pragma omp parallel for num_threads(nthreads) reduction(+ : counter)
+#   pragma omp parallel for num_threads(nthreads) reduction(+ : counter, kmers)
     for (unsigned i = 0; i < (unsigned)streams_.size(); ++i) {
-      counter += FillBufferFromStream(streams_[i], omp_get_thread_num());
+      counter += FillBufferFromStream(streams_[i], omp_get_thread_num(), kmers);
     }
 
     this->DumpBuffers(out);
@@ -129,6 +133,8 @@ DeBruijnReadKMerSplitter<Read, KmerFilter>::Split(size_t num_files, unsigned nth
 
   this->ClearBuffers();
   INFO("Used " << counter << " reads");
+  utils::count_items("kmer_split_reads", counter);
+  utils::count_items("kmer_split_kmers", kmers);
   return out;
 }
 
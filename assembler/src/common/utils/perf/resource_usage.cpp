@@ -0,0 +1,95 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "resource_usage.hpp"
+
+#include "utils/memory_limit.hpp"
+
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace utils {
+
+static double to_seconds(const timeval &tv) {
+    return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+}
+
+resource_usage resource_usage::current() {
+    resource_usage res;
+
+    timeval now;
+    gettimeofday(&now, NULL);
+    res.wall_time = to_seconds(now);
+
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        res.cpu_time = to_seconds(ru.ru_utime) + to_seconds(ru.ru_stime);
+    res.max_rss = get_max_rss();
+
+    // All are Linux-specific, just leave zeros elsewhere
+    {
+        std::ifstream status("/proc/self/status");
+        std::string key;
+        while (status >> key) {
+            if (key == "VmHWM:") {
+                status >> res.peak_rss;
+                break;
+            }
+            status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+    }
+
+    {
+        std::ifstream statm("/proc/self/statm");
+        size_t vsize = 0, rss = 0;
+        if (statm >> vsize >> rss)
+            res.rss = rss * (size_t(sysconf(_SC_PAGE_SIZE)) / 1024);
+    }
+
+    {
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        size_t value;
+        while (io >> key >> value) {
+            if (key == "rchar:")
+                res.read_chars = value;
+            else if (key == "wchar:")
+                res.written_chars = value;
+            else if (key == "read_bytes:")
+                res.read_bytes = value;
+            else if (key == "write_bytes:")
+                res.written_bytes = value;
+        }
+    }
+
+    return res;
+}
+
+bool reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return bool(clear_refs);
+}
+
+static std::mutex items_mutex;
+static std::map<std::string, size_t> items;
+
+void count_items(const std::string &name, size_t count) {
+    std::lock_guard<std::mutex> lock(items_mutex);
+    items[name] += count;
+}
+
+std::map<std::string, size_t> counted_items() {
+    std::lock_guard<std::mutex> lock(items_mutex);
+    return items;
+}
+
+}
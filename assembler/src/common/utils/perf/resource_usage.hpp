@@ -0,0 +1,39 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <cstddef>
+
+namespace utils {
+
+// Snapshot of the resources consumed by the process so far
+struct resource_usage {
+    double wall_time = 0;          // seconds since epoch
+    double cpu_time = 0;           // user + system, seconds
+    size_t max_rss = 0;            // Kb, getrusage() high-water mark, restarted by reset_peak_rss() too
+    size_t peak_rss = 0;           // Kb, high-water mark since the last reset_peak_rss()
+    size_t rss = 0;                // Kb, current
+    size_t read_chars = 0;         // bytes passed through read(2) & friends
+    size_t written_chars = 0;      // bytes passed through write(2) & friends
+    size_t read_bytes = 0;         // bytes fetched from the storage layer
+    size_t written_bytes = 0;      // bytes sent to the storage layer
+
+    static resource_usage current();
+};
+
+// Restarts the peak_rss high-water mark (Linux only, via /proc/self/clear_refs).
+// Returns false if the mark cannot be reset, peak_rss is not meaningful then.
+bool reset_peak_rss();
+
+// Named counters of processed items ("reads", "k-mers", ...). Thread-safe, but
+// not intended to be called for every single item, count in batches.
+void count_items(const std::string &name, size_t count);
+std::map<std::string, size_t> counted_items();
+
+}
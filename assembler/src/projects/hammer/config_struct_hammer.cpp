@@ -69,6 +69,8 @@ void load(hammer_config& cfg, boost::property_tree::ptree const& pt) {
   load(cfg.correct_readbuffer, pt, "correct_readbuffer");
   load(cfg.correct_discard_bad, pt, "correct_discard_bad");
   load(cfg.correct_stats, pt, "correct_stats");
+  cfg.correct_compress_output = false;
+  load(cfg.correct_compress_output, pt, "correct_compress_output", false);
 
   std::string fname;
   load(fname, pt, "dataset");
@@ -77,6 +77,7 @@ struct hammer_config {
   unsigned correct_readbuffer;
   unsigned correct_nthreads;
   bool correct_stats;  
+  bool correct_compress_output;
 };
 
 
@@ -13,24 +13,18 @@
 #include "valid_kmer_generator.hpp"
 
 #include "io/reads/read.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
 #include <vector>
 #include <cstring>
 
-bool Expander::operator()(std::unique_ptr<Read> r) {
-  uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
-
-  // FIXME: Get rid of this
-  Read cr = *r;
-  size_t sz = cr.trimNsAndBadQuality(trim_quality);
-
-  if (sz < hammer::K)
-    return false;
-
+bool Expander::ProcessSequence(const char *seq, const char *qual, size_t sz) {
   std::vector<unsigned> covered_by_solid(sz, false);
+  std::vector<unsigned> covered_by_kmers(sz, false);
   std::vector<size_t> kmer_indices(sz, -1ull);
 
-  ValidKMerGenerator<hammer::K> gen(cr);
+  ValidKMerGenerator<hammer::K> gen(seq, qual, sz);
   while (gen.HasMore()) {
     hammer::KMer kmer = gen.kmer();
     size_t idx = data_.checking_seq_idx(kmer);
@@ -38,17 +32,21 @@ bool Expander::operator()(std::unique_ptr<Read> r) {
       size_t read_pos = gen.pos() - 1;
 
       kmer_indices[read_pos] = idx;
-      if (data_[idx].good()) {
-        for (size_t j = read_pos; j < read_pos + hammer::K; ++j)
-          covered_by_solid[j] = true;
+      bool good = data_[idx].good();
+      for (size_t j = read_pos; j < read_pos + hammer::K; ++j) {
+        covered_by_kmers[j] = true;
+        covered_by_solid[j] = covered_by_solid[j] || good;
       }
     }
     gen.Next();
   }
 
+  // Solid k-mers are never revoked and the index is fixed, so the read is
+  // worth looking at again only if its uncovered positions might get covered
   for (size_t j = 0; j < sz; ++j)
     if (!covered_by_solid[j])
-      return false;
+      return std::all_of(covered_by_kmers.begin(), covered_by_kmers.end(),
+                         [](unsigned covered) { return covered; });
 
   for (size_t j = 0; j < sz; ++j) {
     if (kmer_indices[j] == -1ull)
@@ -65,6 +63,35 @@ bool Expander::operator()(std::unique_ptr<Read> r) {
       kmer_data.unlock();
     }
   }
-    
+
   return false;
 }
+
+bool Expander::operator()(std::unique_ptr<Read> r) {
+  uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
+
+  // FIXME: Get rid of this
+  Read cr = *r;
+  size_t sz = cr.trimNsAndBadQuality(trim_quality);
+
+  if (sz < hammer::K)
+    return false;
+
+  const std::string &seq = cr.getSequenceString(), &qual = cr.getQualityString();
+  if (ProcessSequence(seq.data(), qual.data(), sz) && next_)
+    next_->add(omp_get_thread_num(), seq.data(), qual.data(), sz);
+
+  return false;
+}
+
+void Expander::Run(const ExpansionReadSet &reads, unsigned nthreads) {
+  for (size_t b = 0; b < reads.buffers(); ++b) {
+#   pragma omp parallel for schedule(dynamic, 1024) num_threads(nthreads)
+    for (size_t i = 0; i < reads.size(b); ++i) {
+      const char *seq = reads.seq(b, i), *qual = reads.qual(b, i);
+      size_t sz = reads.length(b, i);
+      if (ProcessSequence(seq, qual, sz) && next_)
+        next_->add(omp_get_thread_num(), seq, qual, sz);
+    }
+  }
+}
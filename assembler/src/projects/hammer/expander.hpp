@@ -11,20 +11,90 @@
 class KMerData;
 class Read;
 
+#include <atomic>
 #include <cstring>
 #include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Trimmed reads that might still turn some k-mers solid during the following
+ * expansion iterations. Reads are appended to per-thread buffers until the
+ * memory budget is exhausted; after that the set is incomplete and the next
+ * iteration has to go over the input files again.
+ */
+class ExpansionReadSet {
+  struct Buffer {
+    std::string seq;
+    std::string qual;
+    std::vector<size_t> offsets;
+
+    Buffer() : offsets(1, 0) {}
+  };
+
+ public:
+  ExpansionReadSet(unsigned nthreads, size_t memory_budget)
+      : buffers_(nthreads), memory_budget_(memory_budget), used_(0), overflow_(false) {}
+
+  // Thread-safe as long as every thread uses its own index
+  void add(unsigned thread, const char *seq, const char *qual, size_t len) {
+    if (overflow_.load(std::memory_order_relaxed))
+      return;
+
+    size_t bytes = 2 * len + sizeof(size_t);
+    if (used_.fetch_add(bytes, std::memory_order_relaxed) + bytes > memory_budget_) {
+      overflow_ = true;
+      return;
+    }
+
+    Buffer &buf = buffers_[thread];
+    buf.seq.append(seq, len);
+    buf.qual.append(qual, len);
+    buf.offsets.push_back(buf.seq.size());
+  }
+
+  bool complete() const { return !overflow_; }
+
+  size_t size() const {
+    size_t res = 0;
+    for (const auto &buf : buffers_)
+      res += buf.offsets.size() - 1;
+    return res;
+  }
+
+  size_t buffers() const { return buffers_.size(); }
+  size_t size(size_t buffer) const { return buffers_[buffer].offsets.size() - 1; }
+
+  const char *seq(size_t buffer, size_t i) const { return buffers_[buffer].seq.data() + buffers_[buffer].offsets[i]; }
+  const char *qual(size_t buffer, size_t i) const { return buffers_[buffer].qual.data() + buffers_[buffer].offsets[i]; }
+  size_t length(size_t buffer, size_t i) const { return buffers_[buffer].offsets[i + 1] - buffers_[buffer].offsets[i]; }
+
+ private:
+  std::vector<Buffer> buffers_;
+  size_t memory_budget_;
+  std::atomic<size_t> used_;
+  std::atomic<bool> overflow_;
+};
 
 class Expander {
   KMerData &data_;
   size_t changed_;
-  
+  ExpansionReadSet *next_;
+
+  // Returns true if the read might produce new solid k-mers in the next iterations
+  bool ProcessSequence(const char *seq, const char *qual, size_t sz);
+
  public:
-  Expander(KMerData &data) 
-      : data_(data), changed_(0) {}
+  /// @param next if set, collects the reads worth looking at in the next iteration
+  Expander(KMerData &data, ExpansionReadSet *next = nullptr)
+      : data_(data), changed_(0), next_(next) {}
 
   size_t changed() const { return changed_; }
 
   bool operator()(std::unique_ptr<Read> r);
+
+  /// processes the reads collected during the previous iteration
+  void Run(const ExpansionReadSet &reads, unsigned nthreads);
 };
 
 #endif
@@ -17,6 +17,8 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <limits>
 
 class EncoderKMer {
 public:
@@ -89,26 +91,100 @@ static bool canMerge(const ConcurrentDSU &uf, size_t x, size_t y) {
 #endif
 
 
-static void processBlockQuadratic(dsu::ConcurrentDSU  &uf,
-                                  const std::vector<size_t>::iterator &block,
-                                  size_t block_size,
-                                  const KMerData &data,
-                                  unsigned tau) {
-  for (size_t i = 0; i < block_size; ++i) {
-    size_t x = block[i];
-    hammer::KMer kmerx = data.kmer(x);
-    for (size_t j = i + 1; j < block_size; j++) {
-      size_t y = block[j];
-      hammer::KMer kmery = data.kmer(y);
-      if (!uf.same(x, y) &&
-          canMerge(uf, x, y) &&
-          hamdistKMer(kmerx, kmery, tau) <= tau) {
-        uf.unite(x, y);
+typedef std::vector<std::pair<uint32_t, uint32_t>> PairVector;
+
+// Finds all the pairs of k-mers of the block within Hamming distance tau. The
+// k-mers are gathered into a contiguous packed array first and compared
+// tile-by-tile, so both tiles stay in L1 while the inner loop runs over packed
+// words only. The pairs are returned in the same (i, j) order as the plain
+// nested loop would visit them.
+static void findClosePairs(const size_t *block, size_t block_size,
+                           const KMerData &data, unsigned tau,
+                           std::vector<hammer::KMer> &kmers,
+                           PairVector &pairs) {
+  const size_t TileSize = 256;
+
+  kmers.clear();
+  for (size_t i = 0; i < block_size; ++i)
+    kmers.push_back(data.kmer(block[i]));
+
+  for (size_t ti = 0; ti < block_size; ti += TileSize) {
+    size_t te = std::min(block_size, ti + TileSize);
+    for (size_t tj = ti; tj < block_size; tj += TileSize) {
+      size_t tje = std::min(block_size, tj + TileSize);
+      for (size_t i = ti; i < te; ++i) {
+        const hammer::KMer kmerx = kmers[i];
+        for (size_t j = std::max(tj, i + 1); j < tje; ++j) {
+          if (hamdistPackedKMer(kmerx, kmers[j]) <= tau)
+            pairs.emplace_back(uint32_t(i), uint32_t(j));
+        }
       }
     }
   }
+
+  if (block_size > TileSize)
+    std::sort(pairs.begin(), pairs.end());
 }
 
+// Accumulates blocks of k-mers sharing a sub-k-mer and clusters them in
+// batches. Close pairs are searched for in parallel, while the unions are
+// applied afterwards in the original block order, so the result is the same
+// as of the serial quadratic processing regardless of the number of threads.
+class QuadraticBlockBatch {
+ public:
+  QuadraticBlockBatch(dsu::ConcurrentDSU &uf, const KMerData &data, unsigned tau,
+                      size_t max_kmers = 1 << 22)
+      : uf_(uf), data_(data), tau_(tau), max_kmers_(max_kmers), offsets_(1, 0) {}
+
+  void add(const std::vector<size_t>::iterator &block, size_t block_size) {
+    if (block_size < 2)
+      return;
+
+    VERIFY(block_size <= std::numeric_limits<uint32_t>::max());
+    indices_.insert(indices_.end(), block, block + block_size);
+    offsets_.push_back(indices_.size());
+    if (indices_.size() >= max_kmers_)
+      flush();
+  }
+
+  void flush() {
+    size_t nblocks = offsets_.size() - 1;
+    if (!nblocks)
+      return;
+
+    std::vector<PairVector> pairs(nblocks);
+    unsigned nthreads = cfg::get().general_max_nthreads;
+#   pragma omp parallel num_threads(nthreads)
+    {
+      std::vector<hammer::KMer> kmers;
+#     pragma omp for schedule(dynamic)
+      for (size_t b = 0; b < nblocks; ++b)
+        findClosePairs(indices_.data() + offsets_[b], offsets_[b + 1] - offsets_[b],
+                       data_, tau_, kmers, pairs[b]);
+    }
+
+    for (size_t b = 0; b < nblocks; ++b) {
+      const size_t *block = indices_.data() + offsets_[b];
+      for (const auto &pair : pairs[b]) {
+        size_t x = block[pair.first], y = block[pair.second];
+        if (!uf_.same(x, y) && canMerge(uf_, x, y))
+          uf_.unite(x, y);
+      }
+    }
+
+    indices_.clear();
+    offsets_.resize(1);
+  }
+
+ private:
+  dsu::ConcurrentDSU &uf_;
+  const KMerData &data_;
+  unsigned tau_;
+  size_t max_kmers_;
+  std::vector<size_t> indices_;
+  std::vector<size_t> offsets_;
+};
+
 void KMerHamClusterer::cluster(const std::string &prefix,
                                const KMerData &data,
                                dsu::ConcurrentDSU &uf) {
@@ -143,11 +219,12 @@ void KMerHamClusterer::cluster(const std::string &prefix,
     kfs.open(kfname, std::ios::out | std::ios::binary);
     VERIFY(bfs.good()); VERIFY(kfs.good());
 
+    QuadraticBlockBatch batch(uf, data, tau_);
     std::pair<size_t, size_t> stat =
       Splitter.split([&] (const std::vector<size_t>::iterator &start, size_t sz) {
         if (sz < block_thr) {
           // Merge small blocks.
-          processBlockQuadratic(uf, start, sz, data, tau_);
+          batch.add(start, sz);
         } else {
           big_blocks1 += 1;
           // Otherwise - dump for next iteration.
@@ -167,6 +244,7 @@ void KMerHamClusterer::cluster(const std::string &prefix,
     VERIFY(stat.first == tau_ + 1);
     VERIFY(stat.second <= (tau_ + 1) * data.size());
 
+    batch.flush();
     VERIFY(!bfs.fail()); VERIFY(!kfs.fail());
     bfs.close(); kfs.close();
     INFO("Merge done, total " << big_blocks1 << " new blocks generated.");
@@ -176,6 +254,7 @@ void KMerHamClusterer::cluster(const std::string &prefix,
   {
     INFO("Splitting sub-kmers, pass 2.");
     SubKMerSplitter Splitter(bfname, kfname);
+    QuadraticBlockBatch batch(uf, data, tau_);
     size_t nblocks = 0;
     std::pair<size_t, size_t> stat =
       Splitter.split([&] (const std::vector<size_t>::iterator &start, size_t sz) {
@@ -188,9 +267,10 @@ void KMerHamClusterer::cluster(const std::string &prefix,
           }
 #endif
         }
-        processBlockQuadratic(uf, start, sz, data, tau_);
+        batch.add(start, sz);
         nblocks += 1;
     });
+    batch.flush();
     INFO("Splitting done."
             " Processed " << stat.first << " blocks."
             " Produced " << stat.second << " blocks.");
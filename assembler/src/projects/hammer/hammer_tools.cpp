@@ -16,9 +16,13 @@
 #include "io/kmers/mmapped_writer.hpp"
 #include "utils/filesystem/path_helper.hpp"
 
+#include "threadpool/threadpool.hpp"
+
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
+#include <future>
 
 #include "config_struct_hammer.hpp"
 
@@ -76,9 +80,38 @@ string getFilename( const string & dirprefix, int iter_count, const string & suf
   return tmp.str();
 }
 
-CorrectionStats CorrectReadsBatch(std::vector<bool> &res,
-                       std::vector<Read> &reads, size_t buf_size,
-                       const KMerData &data) {
+CorrectedReadsFile::CorrectedReadsFile(const std::string &fname, bool compress)
+    : fname_(fname), gz_(nullptr) {
+  if (compress) {
+    gz_ = gzopen(fname.c_str(), "wb1");
+    CHECK_FATAL_ERROR(gz_, "Cannot open " << fname << " for writing");
+  } else {
+    os_.open(fname);
+    CHECK_FATAL_ERROR(os_.is_open(), "Cannot open " << fname << " for writing");
+  }
+}
+
+CorrectedReadsFile::~CorrectedReadsFile() {
+  if (gz_)
+    gzclose(gz_);
+}
+
+void CorrectedReadsFile::write(const std::string &data) {
+  if (data.empty())
+    return;
+
+  if (gz_) {
+    int res = gzwrite(gz_, data.data(), (unsigned)data.size());
+    CHECK_FATAL_ERROR(res == (int)data.size(), "Failed to write to " << fname_);
+  } else {
+    os_.write(data.data(), data.size());
+    CHECK_FATAL_ERROR(!os_.fail(), "Failed to write to " << fname_);
+  }
+}
+
+CorrectionStats CorrectReadsBatch(std::vector<uint8_t> &res,
+                                  std::vector<Read> &reads, size_t buf_size,
+                                  const KMerData &data) {
   unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
   bool discard_singletons = cfg::get().bayes_discard_only_singletons;
   bool correct_threshold = cfg::get().correct_use_threshold;
@@ -104,89 +137,164 @@ CorrectionStats CorrectReadsBatch(std::vector<bool> &res,
   return stats;
 }
 
-CorrectionStats CorrectReadFile(const KMerData &data,
-                     const std::string &fname,
-                     std::ofstream *outf_good, std::ofstream *outf_bad) {
-  int qvoffset = cfg::get().input_qvoffset;
-  int trim_quality = cfg::get().input_trim_quality;
+namespace {
+
+// A batch of reads (or read pairs) travelling through the correction pipeline
+struct CorrectionBatch {
+  std::vector<Read> reads[2];
+  std::vector<uint8_t> res[2];
+  size_t size = 0;
+  // Formatted reads, per output file and per formatting block
+  std::vector<std::vector<std::string>> text;
+
+  CorrectionBatch(size_t capacity, size_t noutputs, size_t nblocks)
+      : text(noutputs, std::vector<std::string>(nblocks)) {
+    for (unsigned j = 0; j < 2; ++j) {
+      reads[j].resize(capacity);
+      res[j].resize(capacity);
+    }
+  }
+};
+
+// Formats the reads of a batch in parallel. output(i, j) gives the output
+// file index for j-th read of i-th record (or -1 if it should be skipped),
+// every block keeps the reads in their original order.
+template<class OutputF>
+void FormatBatch(CorrectionBatch &batch, unsigned nreads, int qvoffset,
+                 unsigned nthreads, const OutputF &output) {
+  size_t nblocks = batch.text[0].size();
+  size_t block_size = (batch.size + nblocks - 1) / nblocks;
+
+# pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+  for (size_t b = 0; b < nblocks; ++b) {
+    std::vector<std::ostringstream> os(batch.text.size());
+    size_t start = std::min(batch.size, b * block_size), end = std::min(batch.size, start + block_size);
+    for (size_t i = start; i < end; ++i) {
+      for (unsigned j = 0; j < nreads; ++j)
+        batch.reads[j][i].print(os[output(i, j)], qvoffset);
+    }
 
+    for (size_t o = 0; o < os.size(); ++o)
+      batch.text[o][b] = os[o].str();
+  }
+}
+
+// Three-stage correction pipeline: the next batch is read and the previous
+// one is written in background while the current one is corrected and
+// formatted. The output keeps the order of the input reads.
+template<class ReadF, class FormatF>
+CorrectionStats RunCorrectionPipeline(const KMerData &data, unsigned nreads, size_t noutputs,
+                                      const ReadF &read_batch, const FormatF &format_batch,
+                                      const std::vector<CorrectedReadsFile*> &outputs) {
   unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
   size_t read_buffer_size = correct_nthreads * cfg::get().correct_readbuffer;
-  std::vector<Read> reads(read_buffer_size);
-  std::vector<bool> res(read_buffer_size, false);
+  size_t nblocks = 4 * correct_nthreads;
+
+  std::vector<CorrectionBatch> batches(3, CorrectionBatch(read_buffer_size, noutputs, nblocks));
+  ThreadPool::ThreadPool pool(2);
+
+  std::future<void> read_task = pool.run([&] { read_batch(batches[0]); });
+  std::future<void> write_task;
+  CorrectionStats stats;
+  for (unsigned buffer_no = 0; ; ++buffer_no) {
+    read_task.get();
+    CorrectionBatch &batch = batches[buffer_no % 3];
+    if (!batch.size)
+      break;
+    INFO("Prepared batch " << buffer_no << " of " << batch.size << " reads.");
+
+    // The slot of the next batch has been written out already, see below
+    CorrectionBatch *next = &batches[(buffer_no + 1) % 3];
+    read_task = pool.run([&read_batch, next] { read_batch(*next); });
+
+    for (unsigned j = 0; j < nreads; ++j)
+      stats += CorrectReadsBatch(batch.res[j], batch.reads[j], batch.size, data);
+    format_batch(batch, correct_nthreads);
+    INFO("Processed batch " << buffer_no);
+
+    if (write_task.valid())
+      write_task.get();
+    const CorrectionBatch *done = &batch;
+    write_task = pool.run([done, &outputs, buffer_no] {
+      for (size_t o = 0; o < outputs.size(); ++o) {
+        for (const auto &text : done->text[o])
+          outputs[o]->write(text);
+      }
+      INFO("Written batch " << buffer_no);
+    });
+  }
+
+  if (write_task.valid())
+    write_task.get();
+
+  return stats;
+}
+
+}
+
+CorrectionStats CorrectReadFile(const KMerData &data,
+                                const std::string &fname,
+                                CorrectedReadsFile *outf_good, CorrectedReadsFile *outf_bad) {
+  int qvoffset = cfg::get().input_qvoffset;
+  int trim_quality = cfg::get().input_trim_quality;
 
   ireadstream irs(fname, qvoffset);
   VERIFY(irs.is_open());
 
-  unsigned buffer_no = 0;
-  CorrectionStats stats;
-  while (!irs.eof()) {
+  auto read_batch = [&](CorrectionBatch &batch) {
+    std::vector<Read> &reads = batch.reads[0];
     size_t buf_size = 0;
-    for (; buf_size < read_buffer_size && !irs.eof(); ++buf_size) {
+    for (; buf_size < reads.size() && !irs.eof(); ++buf_size) {
       irs >> reads[buf_size];
       reads[buf_size].trimNsAndBadQuality(trim_quality);
     }
-    INFO("Prepared batch " << buffer_no << " of " << buf_size << " reads.");
+    batch.size = buf_size;
+  };
 
-    stats += CorrectReadsBatch(res, reads, buf_size,
-                               data);
+  auto format_batch = [&](CorrectionBatch &batch, unsigned nthreads) {
+    FormatBatch(batch, 1, qvoffset, nthreads,
+                [&](size_t i, unsigned) { return batch.res[0][i] ? 0 : 1; });
+  };
 
-    INFO("Processed batch " << buffer_no);
-    for (size_t i = 0; i < buf_size; ++i) {
-      reads[i].print(*(res[i] ? outf_good : outf_bad), qvoffset);
-    }
-    INFO("Written batch " << buffer_no);
-    ++buffer_no;
-  }
-  return stats;
+  return RunCorrectionPipeline(data, 1, 2, read_batch, format_batch, { outf_good, outf_bad });
 }
 
 CorrectionStats CorrectPairedReadFiles(const KMerData &data,
-                            const std::string &fnamel, const std::string &fnamer,
-                            ofstream * ofbadl, ofstream * ofcorl, ofstream * ofbadr, ofstream * ofcorr, ofstream * ofunp) {
+                                       const std::string &fnamel, const std::string &fnamer,
+                                       CorrectedReadsFile *ofbadl, CorrectedReadsFile *ofcorl,
+                                       CorrectedReadsFile *ofbadr, CorrectedReadsFile *ofcorr,
+                                       CorrectedReadsFile *ofunp) {
   int qvoffset = cfg::get().input_qvoffset;
   int trim_quality = cfg::get().input_trim_quality;
 
-  unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
-  size_t read_buffer_size = correct_nthreads * cfg::get().correct_readbuffer;
-  std::vector<Read> l(read_buffer_size);
-  std::vector<Read> r(read_buffer_size);
-  std::vector<bool> left_res(read_buffer_size, false);
-  std::vector<bool> right_res(read_buffer_size, false);
-
-  unsigned buffer_no = 0;
-
   ireadstream irsl(fnamel, qvoffset), irsr(fnamer, qvoffset);
   VERIFY(irsl.is_open()); VERIFY(irsr.is_open());
-  CorrectionStats stats;
 
-  while (!irsl.eof() && !irsr.eof()) {
+  auto read_batch = [&](CorrectionBatch &batch) {
+    std::vector<Read> &l = batch.reads[0], &r = batch.reads[1];
     size_t buf_size = 0;
-    for (; buf_size < read_buffer_size && !irsl.eof() && !irsr.eof(); ++buf_size) {
+    for (; buf_size < l.size() && !irsl.eof() && !irsr.eof(); ++buf_size) {
       irsl >> l[buf_size]; irsr >> r[buf_size];
       l[buf_size].trimNsAndBadQuality(trim_quality);
       r[buf_size].trimNsAndBadQuality(trim_quality);
     }
-    INFO("Prepared batch " << buffer_no << " of " << buf_size << " reads.");
-
-    stats += CorrectReadsBatch(left_res, l, buf_size,
-                      data);
-    stats += CorrectReadsBatch(right_res, r, buf_size,
-                      data);
-
-    INFO("Processed batch " << buffer_no);
-    for (size_t i = 0; i < buf_size; ++i) {
-      if (left_res[i] && right_res[i]) {
-        l[i].print(*ofcorl, qvoffset);
-        r[i].print(*ofcorr, qvoffset);
-      } else {
-        l[i].print(*(left_res[i] ? ofunp : ofbadl), qvoffset);
-        r[i].print(*(right_res[i] ? ofunp : ofbadr), qvoffset);
-      }
-    }
-    INFO("Written batch " << buffer_no);
-    ++buffer_no;
-  }
+    batch.size = buf_size;
+  };
+
+  // Outputs: 0 - corrected left, 1 - corrected right, 2 - unpaired, 3 - bad left, 4 - bad right
+  auto format_batch = [&](CorrectionBatch &batch, unsigned nthreads) {
+    FormatBatch(batch, 2, qvoffset, nthreads,
+                [&](size_t i, unsigned j) {
+                  bool left = batch.res[0][i], right = batch.res[1][i];
+                  if (left && right)
+                    return j;
+                  return (j == 0 ? left : right) ? 2u : 3u + j;
+                });
+  };
+
+  CorrectionStats stats =
+      RunCorrectionPipeline(data, 2, 5, read_batch, format_batch,
+                            { ofcorl, ofcorr, ofunp, ofbadl, ofbadr });
   if (!irsl.eof() || !irsr.eof())
       FATAL_ERROR("Pair of read files " + fnamel + " and " + fnamer + " contain unequal amount of reads");
   return stats;
@@ -207,10 +315,11 @@ std::string CorrectSingleReadSet(size_t ilib, size_t iread, const std::string &f
   std::string usuffix = std::to_string(ilib) + "_" +
                         std::to_string(iread) + ".cor.fastq";
 
-  std::string outcor = getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, usuffix);
-  std::ofstream ofgood(outcor.c_str());
-  std::ofstream ofbad(getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, "bad.fastq").c_str(),
-                      std::ios::out | std::ios::ate);
+  bool compress = cfg::get().correct_compress_output;
+  std::string gz = compress ? ".gz" : "";
+  std::string outcor = getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, usuffix + gz);
+  CorrectedReadsFile ofgood(outcor, compress);
+  CorrectedReadsFile ofbad(getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, "bad.fastq" + gz), compress);
   stats += CorrectReadFile(*Globals::kmer_data, fn, &ofgood, &ofbad);
   return outcor;
 }
@@ -238,17 +347,17 @@ size_t CorrectAllReads() {
 
       std::string unpaired = getLargestPrefix(I->first, I->second) + "_unpaired.fastq";
 
-      std::string outcorl = getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, usuffix);
-      std::string outcorr = getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, usuffix);
-      std::string outcoru = getReadsFilename(cfg::get().output_dir, unpaired,  Globals::iteration_no, usuffix);
-
-      std::ofstream ofcorl(outcorl.c_str());
-      std::ofstream ofbadl(getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, "bad.fastq").c_str(),
-                           std::ios::out | std::ios::ate);
-      std::ofstream ofcorr(outcorr.c_str());
-      std::ofstream ofbadr(getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, "bad.fastq").c_str(),
-                           std::ios::out | std::ios::ate);
-      std::ofstream ofunp (outcoru.c_str());
+      bool compress = cfg::get().correct_compress_output;
+      std::string gz = compress ? ".gz" : "";
+      std::string outcorl = getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, usuffix + gz);
+      std::string outcorr = getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, usuffix + gz);
+      std::string outcoru = getReadsFilename(cfg::get().output_dir, unpaired,  Globals::iteration_no, usuffix + gz);
+
+      CorrectedReadsFile ofcorl(outcorl, compress);
+      CorrectedReadsFile ofbadl(getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, "bad.fastq" + gz), compress);
+      CorrectedReadsFile ofcorr(outcorr, compress);
+      CorrectedReadsFile ofbadr(getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, "bad.fastq" + gz), compress);
+      CorrectedReadsFile ofunp(outcoru, compress);
 
       stats += CorrectPairedReadFiles(*Globals::kmer_data,
                              I->first, I->second,
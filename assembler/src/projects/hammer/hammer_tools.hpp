@@ -20,6 +20,8 @@
 #include "kmer_stat.hpp"
 #include "io/kmers/mmapped_reader.hpp"
 
+#include <zlib.h>
+
 namespace hammer {
 
 /// initialize subkmer positions and log about it
@@ -44,22 +46,35 @@ struct CorrectionStats {
   }
 };
 
+/// output file with corrected reads, gzip-compressed if requested
+class CorrectedReadsFile {
+ public:
+  CorrectedReadsFile(const std::string &fname, bool compress);
+  ~CorrectedReadsFile();
+
+  void write(const std::string &data);
+
+ private:
+  std::string fname_;
+  std::ofstream os_;
+  gzFile gz_;
+};
+
 /// parallel correction of batch of reads
-CorrectionStats CorrectReadsBatch(std::vector<bool> &res, std::vector<Read> &reads, size_t buf_size,
-                       size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
-                       const KMerData &data);
+CorrectionStats CorrectReadsBatch(std::vector<uint8_t> &res, std::vector<Read> &reads, size_t buf_size,
+                                  const KMerData &data);
 
 /// correct reads in a given file
 CorrectionStats CorrectReadFile(const KMerData &data,
-                         size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
-                         const std::string &fname,
-                         std::ofstream *outf_good, std::ofstream *outf_bad);
+                                const std::string &fname,
+                                CorrectedReadsFile *outf_good, CorrectedReadsFile *outf_bad);
 
 /// correct reads in a given pair of files
 CorrectionStats CorrectPairedReadFiles(const KMerData &data,
-                            size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
-                            const std::string &fnamel, const std::string &fnamer,
-                            std::ofstream * ofbadl, std::ofstream * ofcorl, std::ofstream * ofbadr, std::ofstream * ofcorr, std::ofstream * ofunp);
+                                       const std::string &fnamel, const std::string &fnamer,
+                                       CorrectedReadsFile *ofbadl, CorrectedReadsFile *ofcorl,
+                                       CorrectedReadsFile *ofbadr, CorrectedReadsFile *ofcorr,
+                                       CorrectedReadsFile *ofunp);
 /// correct all reads
 size_t CorrectAllReads();
 
@@ -20,6 +20,8 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <numeric>
+#include <sstream>
 
 using std::max_element;
 using std::min_element;
@@ -452,42 +454,40 @@ static void UpdateErrors(numeric::matrix<uint64_t> &m,
   }
 }
 
-size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
-                                      numeric::matrix<uint64_t> &errs,
-                                      std::ofstream &ofs, std::ofstream &ofs_bad,
-                                      size_t &gsingl, size_t &tsingl, size_t &tcsingl, size_t &gcsingl,
-                                      size_t &tcls, size_t &gcls, size_t &tkmers, size_t &tncls) {
-    size_t newkmers = 0;
+KMerClustering::Stats &KMerClustering::Stats::operator+=(const Stats &other) {
+    newkmers += other.newkmers;
+    gsingl += other.gsingl; tsingl += other.tsingl;
+    tcsingl += other.tcsingl; gcsingl += other.gcsingl;
+    tcls += other.tcls; gcls += other.gcls;
+    tkmers += other.tkmers; tncls += other.tncls;
+    return *this;
+}
 
+void KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
+                                    numeric::matrix<uint64_t> &errs,
+                                    std::ostream *ofs, std::ostream *ofs_bad,
+                                    Stats &stats) {
     // No need for clustering for singletons
     if (cur_class.size() == 1) {
         size_t idx = cur_class[0];
         KMerStat &singl = data_[idx];
         if ((1-singl.total_qual) > cfg::get().bayes_singleton_threshold) {
             singl.mark_good();
-            gsingl += 1;
+            stats.gsingl += 1;
 
-            if (ofs.good()) {
-#               pragma omp critical
-                {
-                    ofs << " good singleton: " << idx << "\n  " << singl << '\n';
-                }
-            }
+            if (ofs)
+                *ofs << " good singleton: " << idx << "\n  " << singl << '\n';
         } else {
             if (cfg::get().correct_use_threshold && (1-singl.total_qual) > cfg::get().correct_threshold)
                 singl.mark_good();
             else
                 singl.mark_bad();
 
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " bad singleton: " << idx << "\n  " << singl << '\n';
-                }
-            }
+            if (ofs_bad)
+                *ofs_bad << " bad singleton: " << idx << "\n  " << singl << '\n';
         }
-        tsingl += 1;
-        return 0;
+        stats.tsingl += 1;
+        return;
     }
 
     std::vector<std::vector<size_t> > blocksInPlace;
@@ -497,9 +497,9 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
           std::cout << "process_SIN with size=" << cur_class.size() << std::endl;
         }
       }
-    newkmers += SubClusterSingle(cur_class, blocksInPlace);
+    stats.newkmers += SubClusterSingle(cur_class, blocksInPlace);
 
-    tncls += 1;
+    stats.tncls += 1;
     for (size_t m = 0; m < blocksInPlace.size(); ++m) {
         const std::vector<size_t> &currentBlock = blocksInPlace[m];
         if (currentBlock.size() == 0)
@@ -520,9 +520,9 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
         }
 
         if (currentBlock.size() == 1)
-            tcsingl += 1;
+            stats.tcsingl += 1;
         else
-            tcls += 1;
+            stats.tcls += 1;
 
         if ((center_quality > cfg::get().bayes_singleton_threshold &&
              cluster_quality > cfg::get().bayes_nonsingleton_threshold) ||
@@ -530,32 +530,24 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
           center.mark_good();
 
           if (currentBlock.size() == 1)
-              gcsingl += 1;
+              stats.gcsingl += 1;
           else
-              gcls += 1;
-
-          if (ofs.good()) {
-#             pragma omp critical
-              {
-                  ofs << " center of good cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                  << center << '\n';
-              }
-          }
+              stats.gcls += 1;
+
+          if (ofs)
+              *ofs << " center of good cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                   << center << '\n';
         } else {
             if (cfg::get().correct_use_threshold && center_quality > cfg::get().correct_threshold)
                 center.mark_good();
             else
                 center.mark_bad();
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " center of bad cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                            << center << '\n';
-                }
-            }
+            if (ofs_bad)
+                *ofs_bad << " center of bad cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                         << center << '\n';
         }
 
-        tkmers += currentBlock.size();
+        stats.tkmers += currentBlock.size();
 
         for (size_t j = 1; j < currentBlock.size(); ++j) {
             size_t eidx = currentBlock[j];
@@ -563,17 +555,11 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
 
             UpdateErrors(errs, data_.kmer(eidx), ckmer);
 
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " part of cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                            << kms << '\n';
-                }
-            }
+            if (ofs_bad)
+                *ofs_bad << " part of cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                         << kms << '\n';
         }
     }
-
-    return newkmers;
 }
 
 
@@ -587,55 +573,67 @@ public:
   }
 };
 
-void KMerClustering::process(const std::string &Prefix) {
-  size_t newkmers = 0;
-  size_t gsingl = 0, tsingl = 0, tcsingl = 0, gcsingl = 0, tcls = 0, gcls = 0, tkmers = 0, tncls = 0;
+// Moves the buffered text to the output file once there is enough of it
+static void FlushBuffer(std::ostringstream &buf, std::ofstream &os, bool force = false) {
+  const std::streamoff FlushSize = 1 << 20;
+  if (!force && buf.tellp() < FlushSize)
+    return;
+
+  const std::string s = buf.str();
+# pragma omp critical(kmer_cluster_output)
+  {
+    os.write(s.data(), s.size());
+  }
+  buf.str("");
+}
 
+void KMerClustering::ProcessClusters(const size_t *entries, const std::vector<size_t> &offsets) {
   std::ofstream ofs, ofs_bad;
   if (cfg::get().bayes_write_solid_kmers)
     ofs.open(GetGoodKMersFname());
   if (cfg::get().bayes_write_bad_kmers)
     ofs_bad.open(GetBadKMersFname());
 
-  // Open and read index file
-  MMappedRecordReader<size_t> findex(Prefix + ".idx",  /* unlink */ !debug_, -1ULL);
-
+  Stats stats;
   std::vector<numeric::matrix<uint64_t> > errs(nthreads_, numeric::matrix<double>(4, 4, 0.0));
+  size_t nclusters = offsets.size() - 1;
 
-# pragma omp parallel for shared(ofs, ofs_bad, errs) num_threads(nthreads_) schedule(guided) reduction(+:newkmers, gsingl, tsingl, tcsingl, gcsingl, tcls, gcls, tkmers, tncls)
-  for (size_t chunk = 0; chunk < nthreads_ * nthreads_; ++chunk) {
-      size_t *current = findex.data() + findex.size() * chunk / nthreads_ / nthreads_;
-      size_t *next = findex.data() + findex.size() * (chunk + 1)/ nthreads_ / nthreads_;
-      std::ifstream is(Prefix, std::ios::in | std::ios::binary);
-
-      // Calculate how much we need to seek
-      size_t soff = 0;
-      for (size_t *csz = findex.data(); csz != current; ++csz)
-          soff += *csz;
+# pragma omp parallel num_threads(nthreads_)
+  {
+      // Every thread collects its own statistics and output, which are merged at the end
+      Stats local_stats;
+      std::ostringstream good_buf, bad_buf;
+      std::ostream *good_out = ofs.is_open() ? &good_buf : nullptr;
+      std::ostream *bad_out = ofs_bad.is_open() ? &bad_buf : nullptr;
+      std::vector<size_t> cluster;
 
-      // Now see the stream and start processing
-      is.seekg(soff * sizeof(size_t));
-
-      for (; current != next; ++current) {
-          std::vector<size_t> cluster(*current);
-          VERIFY(is.good());
-          is.read((char*)&cluster[0], *current * sizeof(cluster[0]));
+#     pragma omp for schedule(dynamic, 64)
+      for (size_t i = 0; i < nclusters; ++i) {
+          cluster.assign(entries + offsets[i], entries + offsets[i + 1]);
 
           // Underlying code expected classes to be sorted in count decreasing order.
           std::sort(cluster.begin(), cluster.end(), KMerStatCountComparator(data_));
 
-          newkmers += ProcessCluster(cluster,
-                                     errs[omp_get_thread_num()],
-                                     ofs, ofs_bad,
-                                     gsingl, tsingl, tcsingl, gcsingl,
-                                     tcls, gcls, tkmers, tncls);
+          ProcessCluster(cluster,
+                         errs[omp_get_thread_num()],
+                         good_out, bad_out,
+                         local_stats);
+
+          if (good_out)
+              FlushBuffer(good_buf, ofs);
+          if (bad_out)
+              FlushBuffer(bad_buf, ofs_bad);
       }
-  }
 
-  if (!debug_) {
-      int res = unlink(Prefix.c_str());
-      CHECK_FATAL_ERROR(res == 0,
-                        "unlink(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
+      if (good_out)
+          FlushBuffer(good_buf, ofs, /* force */ true);
+      if (bad_out)
+          FlushBuffer(bad_buf, ofs_bad, /* force */ true);
+
+#     pragma omp critical(kmer_cluster_stats)
+      {
+          stats += local_stats;
+      }
   }
 
   for (unsigned i = 1; i < nthreads_; ++i)
@@ -647,13 +645,30 @@ void KMerClustering::process(const std::string &Prefix) {
     for (unsigned j = 0; j < 4; ++j)
       err(i, j) = 1.0 * (double)errs[0](i, j) / (double)rowsums(i, 0);
 
-  INFO("Subclustering done. Total " << newkmers << " non-read kmers were generated.");
+  INFO("Subclustering done. Total " << stats.newkmers << " non-read kmers were generated.");
   INFO("Subclustering statistics:");
-  INFO("  Total singleton hamming clusters: " << tsingl << ". Among them " << gsingl << " (" << 100.0 * (double)gsingl / (double)tsingl << "%) are good");
-  INFO("  Total singleton subclusters: " << tcsingl << ". Among them " << gcsingl << " (" << 100.0 * (double)gcsingl / (double)tcsingl << "%) are good");
-  INFO("  Total non-singleton subcluster centers: " << tcls << ". Among them " << gcls << " (" << 100.0 * (double)gcls / (double)tcls << "%) are good");
-  INFO("  Average size of non-trivial subcluster: " << 1.0 * (double)tkmers / (double)tcls << " kmers");
-  INFO("  Average number of sub-clusters per non-singleton cluster: " << 1.0 * (double)(tcsingl + tcls) / (double)tncls);
-  INFO("  Total solid k-mers: " << gsingl + gcsingl + gcls);
+  INFO("  Total singleton hamming clusters: " << stats.tsingl << ". Among them " << stats.gsingl << " (" << 100.0 * (double)stats.gsingl / (double)stats.tsingl << "%) are good");
+  INFO("  Total singleton subclusters: " << stats.tcsingl << ". Among them " << stats.gcsingl << " (" << 100.0 * (double)stats.gcsingl / (double)stats.tcsingl << "%) are good");
+  INFO("  Total non-singleton subcluster centers: " << stats.tcls << ". Among them " << stats.gcls << " (" << 100.0 * (double)stats.gcls / (double)stats.tcls << "%) are good");
+  INFO("  Average size of non-trivial subcluster: " << 1.0 * (double)stats.tkmers / (double)stats.tcls << " kmers");
+  INFO("  Average number of sub-clusters per non-singleton cluster: " << 1.0 * (double)(stats.tcsingl + stats.tcls) / (double)stats.tncls);
+  INFO("  Total solid k-mers: " << stats.gsingl + stats.gcsingl + stats.gcls);
   INFO("  Substitution probabilities: " << err);
 }
+
+void KMerClustering::process(const std::vector<size_t> &entries, const std::vector<size_t> &offsets) {
+  ProcessClusters(entries.data(), offsets);
+}
+
+void KMerClustering::process(const std::string &Prefix) {
+  // Open and read index file
+  MMappedRecordReader<size_t> findex(Prefix + ".idx",  /* unlink */ !debug_, -1ULL);
+
+  std::vector<size_t> offsets(findex.size() + 1, 0);
+  std::partial_sum(findex.data(), findex.data() + findex.size(), offsets.begin() + 1);
+
+  MMappedRecordReader<size_t> fclusters(Prefix,  /* unlink */ !debug_, -1ULL);
+  VERIFY(fclusters.size() == offsets.back());
+
+  ProcessClusters(fclusters.data(), offsets);
+}
@@ -29,6 +29,8 @@ public:
       data_(data), nthreads_(nthreads), workdir_(workdir), debug_(debug) { }
 
   void process(const std::string &Prefix);
+  // Clusters are given as a flat array, see dsu::ConcurrentDSU::extract()
+  void process(const std::vector<size_t> &entries, const std::vector<size_t> &offsets);
 
 private:
   KMerData &data_;
@@ -36,6 +38,14 @@ private:
   std::string workdir_;
   bool debug_;
 
+  struct Stats {
+    size_t newkmers = 0;
+    size_t gsingl = 0, tsingl = 0, tcsingl = 0, gcsingl = 0;
+    size_t tcls = 0, gcls = 0, tkmers = 0, tncls = 0;
+
+    Stats &operator+=(const Stats &other);
+  };
+
   struct Center {
     hammer::ExpandedSeq center_;
     size_t count_;
@@ -58,11 +68,12 @@ private:
   std::string GetGoodKMersFname() const;
   std::string GetBadKMersFname() const;
 
-  size_t ProcessCluster(const std::vector<size_t> &cur_class,
-                        boost::numeric::ublas::matrix<uint64_t> &errs,
-                        std::ofstream &ofs, std::ofstream &ofs_bad,
-                        size_t &gsingl, size_t &tsingl, size_t &tcsingl, size_t &gcsingl,
-                        size_t &tcls, size_t &gcls, size_t &tkmers, size_t &tncls);
+  void ProcessCluster(const std::vector<size_t> &cur_class,
+                      boost::numeric::ublas::matrix<uint64_t> &errs,
+                      std::ostream *ofs, std::ostream *ofs_bad,
+                      Stats &stats);
+
+  void ProcessClusters(const size_t *entries, const std::vector<size_t> &offsets);
 
 private:
   DECL_LOGGER("Hamming Subclustering");
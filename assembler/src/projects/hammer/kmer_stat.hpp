@@ -46,6 +46,22 @@ static inline unsigned hamdistKMer(const hammer::KMer &x, const hammer::KMer &y,
   return dist;
 }
 
+// Branch-free version of the above: XOR of the 2-bit encodings has a non-zero
+// nucleotide slot exactly at mismatches, so fold every slot into its low bit
+// and popcount the result.
+static inline unsigned hamdistPackedKMer(const hammer::KMer &x, const hammer::KMer &y) {
+  typedef hammer::KMer::DataType DataType;
+  const DataType LowBits = (DataType)0x5555555555555555ULL;
+  const DataType *xd = x.data(), *yd = y.data();
+
+  unsigned dist = 0;
+  for (size_t i = 0; i < hammer::KMer::DataSize; ++i) {
+    DataType d = xd[i] ^ yd[i];
+    dist += (unsigned)__builtin_popcountll((d | (d >> 1)) & LowBits);
+  }
+  return dist;
+}
+
 template<unsigned N, unsigned bits,
          typename Storage = uint64_t>
 class NibbleString {
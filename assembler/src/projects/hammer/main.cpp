@@ -142,6 +142,10 @@ int main(int argc, char * argv[]) {
 
       // Cluster the Hamming graph
       std::vector<std::vector<size_t> > classes;
+      // Clusters are passed to subclustering in memory when it runs right
+      // away and they fit into a reasonable share of free memory
+      std::vector<size_t> cluster_entries, cluster_offsets;
+      bool clusters_in_memory = false;
       if (cfg::get().hamming_do || do_everything) {
         dsu::ConcurrentDSU uf(Globals::kmer_data->size());
         std::string ham_prefix = hammer::getFilename(cfg::get().input_working_dir, Globals::iteration_no, "kmers.hamcls");
@@ -153,7 +157,13 @@ int main(int argc, char * argv[]) {
         }
 
         INFO("Extracting clusters:");
-        size_t num_classes = uf.extract_to_file(hammer::getFilename(cfg::get().input_working_dir, Globals::iteration_no, "kmers.hamming"));
+        size_t clusters_size = 2 * Globals::kmer_data->size() * sizeof(size_t);
+        clusters_in_memory = (cfg::get().bayes_do || do_everything) && !cfg::get().general_debug &&
+                             clusters_size < utils::get_free_memory() / 4;
+        size_t num_classes =
+            clusters_in_memory ?
+            uf.extract(cluster_entries, cluster_offsets) :
+            uf.extract_to_file(hammer::getFilename(cfg::get().input_working_dir, Globals::iteration_no, "kmers.hamming"));
 
 #if 0
         std::sort(classes.begin(), classes.end(),  UfCmp());
@@ -174,7 +184,12 @@ int main(int argc, char * argv[]) {
         unsigned clustering_nthreads = std::min(cfg::get().general_max_nthreads, cfg::get().bayes_nthreads);
         KMerClustering kmc(*Globals::kmer_data, clustering_nthreads,
                            cfg::get().input_working_dir, cfg::get().general_debug);
-        kmc.process(hammer::getFilename(cfg::get().input_working_dir, Globals::iteration_no, "kmers.hamming"));
+        if (clusters_in_memory) {
+          kmc.process(cluster_entries, cluster_offsets);
+          std::vector<size_t>().swap(cluster_entries);
+          std::vector<size_t>().swap(cluster_offsets);
+        } else
+          kmc.process(hammer::getFilename(cfg::get().input_working_dir, Globals::iteration_no, "kmers.hamming"));
         INFO("Finished clustering.");
 
         if (cfg::get().general_debug) {
@@ -195,15 +210,25 @@ int main(int argc, char * argv[]) {
       if (cfg::get().expand_do || do_everything) {
         unsigned expand_nthreads = std::min(cfg::get().general_max_nthreads, cfg::get().expand_nthreads);
         INFO("Starting solid k-mers expansion in " << expand_nthreads << " threads.");
+        // Reads which might still produce new solid k-mers, only these are
+        // looked at during the following iterations
+        std::unique_ptr<ExpansionReadSet> expand_reads;
         for (unsigned expand_iter_no = 0; expand_iter_no < cfg::get().expand_max_iterations; ++expand_iter_no) {
-          Expander expander(*Globals::kmer_data);
-          const io::DataSet<> &dataset = cfg::get().dataset;
-          for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
-            ireadstream irs(*I, cfg::get().input_qvoffset);
-            hammer::ReadProcessor rp(expand_nthreads);
-            rp.Run(irs, expander);
-            VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
+          auto next_reads = std::make_unique<ExpansionReadSet>(expand_nthreads, utils::get_free_memory() / 4);
+          Expander expander(*Globals::kmer_data, next_reads.get());
+          if (expand_reads && expand_reads->complete()) {
+            INFO("Processing " << expand_reads->size() << " reads retained from the previous iteration");
+            expander.Run(*expand_reads, expand_nthreads);
+          } else {
+            const io::DataSet<> &dataset = cfg::get().dataset;
+            for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
+              ireadstream irs(*I, cfg::get().input_qvoffset);
+              hammer::ReadProcessor rp(expand_nthreads);
+              rp.Run(irs, expander);
+              VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
+            }
           }
+          expand_reads = std::move(next_reads);
 
           if (cfg::get().expand_write_each_iteration) {
             std::ofstream oftmp(hammer::getFilename(cfg::get().input_working_dir, Globals::iteration_no, "goodkmers", expand_iter_no).data());
@@ -0,0 +1,76 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#ifndef __CLUSTER_STORAGE_HPP__
+#define __CLUSTER_STORAGE_HPP__
+
+#include "adt/iterator_range.hpp"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+namespace hammer {
+
+// Hamming clusters in CSR layout: k-mer indices of the i-th cluster are
+// stored in entries_[offsets_[i]..offsets_[i + 1]).
+class ClusterStorage {
+  std::vector<size_t> entries_;
+  std::vector<size_t> offsets_;
+
+ public:
+  typedef adt::iterator_range<const size_t*> Cluster;
+
+  ClusterStorage() : offsets_(1, 0) {}
+
+  std::vector<size_t>& entries() { return entries_; }
+  std::vector<size_t>& offsets() { return offsets_; }
+
+  size_t size() const { return offsets_.size() - 1; }
+  size_t cluster_size(size_t i) const { return offsets_[i + 1] - offsets_[i]; }
+
+  Cluster operator[](size_t i) const {
+    const size_t* data = entries_.data();
+    return Cluster(data + offsets_[i], data + offsets_[i + 1]);
+  }
+
+  // Cluster indices ordered by decreasing cluster size (ties keep the
+  // original order), so the most expensive ones are scheduled first.
+  std::vector<size_t> BySizeDesc() const {
+    std::vector<size_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return cluster_size(a) > cluster_size(b);
+    });
+    return order;
+  }
+
+  void BinWrite(std::ostream& os) const {
+    const size_t num_classes = size(), num_entries = entries_.size();
+    os.write((const char*)&num_classes, sizeof(num_classes));
+    os.write((const char*)&num_entries, sizeof(num_entries));
+    os.write((const char*)offsets_.data(), offsets_.size() * sizeof(offsets_[0]));
+    os.write((const char*)entries_.data(), entries_.size() * sizeof(entries_[0]));
+  }
+
+  void BinRead(std::istream& is) {
+    size_t num_classes = 0, num_entries = 0;
+    is.read((char*)&num_classes, sizeof(num_classes));
+    is.read((char*)&num_entries, sizeof(num_entries));
+    offsets_.resize(num_classes + 1);
+    entries_.resize(num_entries);
+    is.read((char*)offsets_.data(), offsets_.size() * sizeof(offsets_[0]));
+    is.read((char*)entries_.data(), entries_.size() * sizeof(entries_[0]));
+    VERIFY(is.good() && offsets_.back() == num_entries);
+  }
+};
+
+}  // namespace hammer
+
+#endif  // __CLUSTER_STORAGE_HPP__
@@ -8,6 +8,7 @@
 #include <common/adt/concurrent_dsu.hpp>
 #include <common/pipeline/config_singl.hpp>
 #include "HSeq.hpp"
+#include "cluster_storage.hpp"
 #include "kmer_data.hpp"
 #include "utils/logger/logger.hpp"
 #include "valid_hkmer_generator.hpp"
@@ -71,8 +72,8 @@ class TOneErrorClustering {
     }
   }
 
-  void FillClasses(std::vector<std::vector<size_t> >& clusters) {
-    clusters_.get_sets(clusters);
+  void FillClasses(ClusterStorage& clusters) {
+    clusters_.extract(clusters.entries(), clusters.offsets());
   }
 };
 
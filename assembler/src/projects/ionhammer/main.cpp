@@ -50,13 +50,6 @@ void create_console_logger() {
   attach_logger(lg);
 }
 
-struct UfCmp {
-  bool operator()(const std::vector<unsigned long>& lhs,
-                  const std::vector<unsigned long>& rhs) {
-    return lhs.size() > rhs.size();
-  }
-};
-
 using namespace n_gamma_poisson_model;
 
 namespace hammer {
@@ -69,7 +62,7 @@ class TKMerDataEstimator {
   KMerData& Data;
   const uint NumFiles;
   const hammer_config::hammer_config& Config;
-  std::vector<std::vector<size_t> > Classes;
+  ClusterStorage Classes;
   NormalClusterModel ClusterModel;
 
   // This is weird workaround for bug in gcc 4.4.7
@@ -99,13 +92,7 @@ class TKMerDataEstimator {
     INFO("Debug mode on. Writing down clusters.");
     std::ofstream ofs(fs::append_path(Config.working_dir, "hamming.cls"),
                       std::ios::binary);
-    const size_t num_classes = Classes.size();
-    ofs.write((char*)&num_classes, sizeof(num_classes));
-    for (size_t i = 0; i < Classes.size(); ++i) {
-      size_t sz = Classes[i].size();
-      ofs.write((char*)&sz, sizeof(sz));
-      ofs.write((char*)&Classes[i][0], sz * sizeof(Classes[i][0]));
-    }
+    Classes.BinWrite(ofs);
   }
 
   void LoadKMerData(std::string filename) {
@@ -135,17 +122,7 @@ class TKMerDataEstimator {
     std::ifstream ifs(fs::append_path(Config.working_dir, "hamming.cls"),
                       std::ios::binary);
     VERIFY(ifs.good());
-
-    size_t num_classes = 0;
-    ifs.read((char*)&num_classes, sizeof(num_classes));
-    Classes.resize(num_classes);
-
-    for (size_t i = 0; i < num_classes; ++i) {
-      size_t sz = 0;
-      ifs.read((char*)&sz, sizeof(sz));
-      Classes[i].resize(sz);
-      ifs.read((char*)&Classes[i][0], sz * sizeof(Classes[i][0]));
-    }
+    Classes.BinRead(ifs);
   }
 
   void EstimateGenomicCenters() {
@@ -158,12 +135,7 @@ class TKMerDataEstimator {
 
     INFO("Subclustering.");
     TGenomicHKMersEstimator genomicHKMersEstimator(Data, ClusterModel, cfg::get().center_type);
-
-#pragma omp parallel for num_threads(num_threads)
-    for (size_t i = 0; i < Classes.size(); ++i) {
-      auto& cluster = Classes[i];
-      genomicHKMersEstimator.ProceedCluster(cluster);
-    }
+    genomicHKMersEstimator.ProceedClusters(Classes, num_threads);
   }
 
   void CalcGenomicEstimationQuality(ClusteringQuality& quality) {
@@ -211,7 +183,8 @@ class TKMerDataEstimator {
       oracle.reset(new TGenomReferenceOracle(oraclePath));
       clusteringQuality.reset(new ClusteringQuality(*oracle, Data));
       for (size_t i = 0; i < Classes.size(); ++i) {
-        clusteringQuality->AddCluster(Classes[i]);
+        auto cluster = Classes[i];
+        clusteringQuality->AddCluster(std::vector<size_t>(cluster.begin(), cluster.end()));
       }
     }
 
@@ -236,9 +209,10 @@ class TKMerDataEstimator {
   void SaveCenters() {
     std::ofstream fasta_ofs("centers.fasta");
     fasta_ofs << std::fixed << std::setprecision(6) << std::setfill('0');
-    std::sort(Classes.begin(), Classes.end(), UfCmp());
-    for (size_t i = 0; i < Classes.size(); ++i) {
-      auto& cluster = Classes[i];
+    const std::vector<size_t> order = Classes.BySizeDesc();
+    for (size_t i = 0; i < order.size(); ++i) {
+      auto range = Classes[order[i]];
+      std::vector<size_t> cluster(range.begin(), range.end());
       std::sort(cluster.begin(), cluster.end(), CountCmp(Data));
       hammer::HKMer c = TGenomicHKMersEstimator::Center(Data, cluster);
       size_t idx = Data.seq_idx(c);
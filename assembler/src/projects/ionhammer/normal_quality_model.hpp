@@ -11,6 +11,7 @@
 #include <boost/math/special_functions/gamma.hpp>
 #include <boost/math/special_functions/trigamma.hpp>
 #include <vector>
+#include "cluster_storage.hpp"
 #include "config_struct.hpp"
 #include "kmer_data.hpp"
 #include "quality_thresholds_estimator.h"
@@ -345,8 +346,7 @@ class ModelEstimator {
         max_iterations_(maxIterations),
         is_calc_likelihood_(calc_likelihood) {}
 
-  NormalClusterModel Estimate(
-      const std::vector<std::vector<size_t> >& clusters) {
+  NormalClusterModel Estimate(const hammer::ClusterStorage& clusters) {
     QualityTransform trans;
 
     std::vector<size_t> cluster_center;
@@ -354,11 +354,12 @@ class ModelEstimator {
       cluster_center.resize(clusters.size());
 #pragma omp parallel for num_threads(num_threads_)
       for (size_t i = 0; i < clusters.size(); ++i) {
-        auto& cluster = clusters[i];
+        auto cluster = clusters[i];
+        const size_t first = *cluster.begin();
 
         double best_qual =
-            trans.Apply(data_[cluster[0]].qual, data_[cluster[0]].count);
-        size_t bestIdx = cluster[0];
+            trans.Apply(data_[first].qual, data_[first].count);
+        size_t bestIdx = first;
 
         for (auto idx : cluster) {
           const auto qual = trans.Apply(data_[idx].qual, data_[idx].count);
@@ -11,6 +11,7 @@
 #include "hkmer_distance.hpp"
 #include "kmer_data.hpp"
 #include "utils/logger/log_writers.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <boost/numeric/ublas/matrix.hpp>
 
@@ -78,7 +79,7 @@ HKMer TGenomicHKMersEstimator::ByPosteriorQualCenter(
   return res;
 }
 
-void TGenomicHKMersEstimator::ProceedCluster(std::vector<size_t>& cluster) {
+void TGenomicHKMersEstimator::ProceedCluster(std::vector<size_t>& cluster, Stats& stats) {
   std::sort(cluster.begin(), cluster.end(), CountCmp(data_));
 
   std::vector<double> qualities;
@@ -253,16 +254,37 @@ void TGenomicHKMersEstimator::ProceedCluster(std::vector<size_t>& cluster) {
     data_[idx].dist_one_subcluster |= distOneGoodCenters[i];
     data_[idx].unlock();
     if (!wasGood && data_[idx].good()) {
-#pragma omp atomic
-      GoodKmers++;
+      ++stats.GoodKmers;
     }
     if (!wasGood && data_[idx].skip()) {
-#pragma omp atomic
-      SkipKmers++;
+      ++stats.SkipKmers;
     }
     if (wasGood) {
-#pragma omp atomic
-      ReasignedByConsenus++;
+      ++stats.ReasignedByConsenus;
     }
   }
 }
+
+void TGenomicHKMersEstimator::ProceedClusters(const ClusterStorage& clusters,
+                                              unsigned num_threads) {
+  // Subclustering cost grows superlinearly with the cluster size and a few
+  // homopolymer clusters are huge, so hand out the clusters one by one
+  // starting from the largest ones.
+  const std::vector<size_t> order = clusters.BySizeDesc();
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    Stats stats;
+    std::vector<size_t> cluster;
+
+#pragma omp for schedule(dynamic, 1) nowait
+    for (size_t i = 0; i < order.size(); ++i) {
+      auto range = clusters[order[i]];
+      cluster.assign(range.begin(), range.end());
+      ProceedCluster(cluster, stats);
+    }
+
+#pragma omp critical(subcluster_stats)
+    stats_ += stats;
+  }
+}
@@ -8,6 +8,7 @@
 #ifndef __SUBCLUSTER_HPP__
 #define __SUBCLUSTER_HPP__
 
+#include "cluster_storage.hpp"
 #include "hkmer.hpp"
 #include "kmer_data.hpp"
 #include "quality_thresholds_estimator.h"
@@ -25,13 +26,26 @@ class ClusteringQuality;
 
 
 class TGenomicHKMersEstimator {
+ public:
+  // Per-thread counters, merged into the estimator once a thread is done
+  struct Stats {
+    size_t GoodKmers = 0;
+    size_t SkipKmers = 0;
+    size_t ReasignedByConsenus = 0;
+
+    Stats& operator+=(const Stats& other) {
+      GoodKmers += other.GoodKmers;
+      SkipKmers += other.SkipKmers;
+      ReasignedByConsenus += other.ReasignedByConsenus;
+      return *this;
+    }
+  };
+
  private:
   KMerData& data_;
   const n_normal_model::NormalClusterModel& cluster_model_;
   hammer_config::CenterType consensus_type_;
-  size_t GoodKmers = 0;
-  size_t SkipKmers = 0;
-  size_t ReasignedByConsenus = 0;
+  Stats stats_;
 
  public:
   TGenomicHKMersEstimator(KMerData& data, const n_normal_model::NormalClusterModel& clusterModel,
@@ -39,9 +53,9 @@ class TGenomicHKMersEstimator {
       : data_(data), cluster_model_(clusterModel), consensus_type_(consensusType) {}
 
   ~TGenomicHKMersEstimator() {
-    INFO("Good kmers: " << GoodKmers);
-    INFO("Perfect kmers: " << SkipKmers);
-    INFO("Reasigned by consensus: " << ReasignedByConsenus);
+    INFO("Good kmers: " << stats_.GoodKmers);
+    INFO("Perfect kmers: " << stats_.SkipKmers);
+    INFO("Reasigned by consensus: " << stats_.ReasignedByConsenus);
   }
 
   // we trying to find center candidate, not error candidates.
@@ -72,7 +86,10 @@ class TGenomicHKMersEstimator {
     return indices;
   }
 
-  void ProceedCluster(std::vector<size_t>& cluster);
+  void ProceedCluster(std::vector<size_t>& cluster, Stats& stats);
+
+  // Subclusters all the clusters in parallel, the largest ones first
+  void ProceedClusters(const ClusterStorage& clusters, unsigned num_threads);
 
   static size_t GetCenterIdx(const KMerData& kmerData,
                              const std::vector<size_t>& cluster) {
@@ -5,6 +5,8 @@
 #include "getopt_pp/getopt_pp.h"
 #include "io/reads/file_reader.hpp"
 #include "io/reads/osequencestream.hpp"
+#include "io/utils/ordered_writer.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "logger.hpp"
 #include "formats.hpp"
 #include "contig_abundance.hpp"
@@ -17,29 +19,43 @@ public:
     template<typename T>
     static void Run(const ProfileCounter<T>& counter, size_t min_length_bound,
                     io::FileReadStream& contigs_stream, std::ofstream& out) {
-        io::SingleRead contig;
-        out << std::defaultfloat << std::fixed << std::setprecision(2);
-        while (!contigs_stream.eof()) {
-            contigs_stream >> contig;
-            contig_id id = GetId(contig);
-            DEBUG("Analyzing contig " << id);
+        const size_t BATCH_SIZE = 100000;
+        std::vector<io::SingleRead> batch;
+        batch.reserve(BATCH_SIZE);
 
-            if (contig.size() < min_length_bound) {
-                DEBUG("Fragment is shorter than min_length_bound " << min_length_bound);
-                break;
+        bool done = false;
+        while (!done && !contigs_stream.eof()) {
+            batch.clear();
+            io::SingleRead contig;
+            while (batch.size() < BATCH_SIZE && !contigs_stream.eof()) {
+                contigs_stream >> contig;
+                if (contig.size() < min_length_bound) {
+                    DEBUG("Fragment " << GetId(contig) << " is shorter than min_length_bound " << min_length_bound);
+                    done = true;
+                    break;
+                }
+                batch.push_back(std::move(contig));
             }
 
-            auto profile = counter(contig.GetSequenceString(), contig.name());
+            // Profiles are estimated in parallel, but written in the input order
+            io::WriteOrdered(out, batch.size(), [&](size_t i, std::ostream &os) {
+                const io::SingleRead &contig = batch[i];
+                contig_id id = GetId(contig);
+                DEBUG("Analyzing contig " << id);
+
+                auto profile = counter(contig.GetSequenceString(), contig.name());
+                if (!profile) {
+                    DEBUG("Failed to estimate abundance of " << id);
+                    return;
+                }
 
-            if (profile) {
                 DEBUG("Successfully estimated abundance of " << id);
-                out << id << "\t";
+                os << std::defaultfloat << std::fixed << std::setprecision(2);
+                os << id << "\t";
                 std::copy(profile->begin(), profile->end(),
-                          std::ostream_iterator<T>(out, "\t"));
-                out << std::endl;
-            } else {
-                DEBUG("Failed to estimate abundance of " << id);
-            }
+                          std::ostream_iterator<T>(os, "\t"));
+                os << '\n';
+            }, 1024);
         }
     }
 private:
@@ -50,7 +66,7 @@ int main(int argc, char** argv) {
     using namespace GetOpt;
 
     unsigned k;
-    size_t sample_cnt, min_length_bound;
+    size_t sample_cnt, min_length_bound, nthreads;
     std::string contigs_path, kmer_mult_fn, contigs_abundance_fn;
     bool var;
 
@@ -63,16 +79,18 @@ int main(int argc, char** argv) {
             >> Option('m', kmer_mult_fn)
             >> Option('o', contigs_abundance_fn)
             >> Option('l', min_length_bound, size_t(0))
+            >> Option('t', "threads", nthreads, size_t(1))
             >> OptionPresent('v', var);
     } catch(GetOptEx &ex) {
         std::cout << "Usage: contig_abundance_counter -k <K> -c <contigs path> "
                 "-n <sample cnt> -m <kmer multiplicities path> -o <contigs abundance path> "
-                "[-v] [-l <contig length bound> (default: 0)]"  << std::endl;
+                "[-v] [-l <contig length bound> (default: 0)] [-t <threads> (default: 1)]"  << std::endl;
         exit(1);
     }
 
     //TmpFolderFixture fixture("tmp");
     create_console_logger();
+    omp_set_num_threads((int) nthreads);
 
     KmerProfileIndex::SetSampleCount(sample_cnt);
 
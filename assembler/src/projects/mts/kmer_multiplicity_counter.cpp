@@ -7,16 +7,17 @@
 #include <memory>
 #include <algorithm>
 #include <libcxx/sort.hpp>
-#include <boost/optional/optional.hpp>
+#include <boost/iterator/iterator_facade.hpp>
 #include "getopt_pp/getopt_pp.h"
 #include "kmc_api/kmc_file.h"
-//#include "omp.h"
+#include "adt/loser_tree.hpp"
 #include "io/kmers/mmapped_reader.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/stl_utils.hpp"
 #include "utils/ph_map/perfect_hash_map_builder.hpp"
 #include "utils/ph_map/storing_traits.hpp"
 #include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "logger.hpp"
 
 using std::string;
@@ -58,83 +59,178 @@ class KmerMultiplicityCounter {
         return sorted_filename;
     }
 
-    bool ReadKmerWithCount(std::ifstream& infile, std::pair<RtSeq, uint32>& res) {
-        RtSeq seq(res.first.size());
-        if (!seq.BinRead(infile)) {
-            return false;
+    typedef uint16_t Mpl;
+
+    // A k-mer record of a sorted sample file: k-mer words followed by the count
+    struct KmerRecord {
+        const seq_element_type *data;
+        size_t sample;
+    };
+
+    class RecordIterator :
+            public boost::iterator_facade<RecordIterator, KmerRecord,
+                                          std::forward_iterator_tag, KmerRecord> {
+    public:
+        RecordIterator()
+                : data_(nullptr), stride_(0), sample_(0) {}
+        RecordIterator(const seq_element_type *data, size_t stride, size_t sample)
+                : data_(data), stride_(stride), sample_(sample) {}
+
+    private:
+        friend class boost::iterator_core_access;
+
+        void increment() { data_ += stride_; }
+        bool equal(const RecordIterator &other) const { return data_ == other.data_; }
+        KmerRecord dereference() const { return { data_, sample_ }; }
+
+        const seq_element_type *data_;
+        size_t stride_;
+        size_t sample_;
+    };
+
+    // Orders records by k-mer words, which is the order of the sorted files
+    struct RecordLess {
+        size_t kmer_words;
+
+        bool operator()(const seq_element_type *lhs, const seq_element_type *rhs) const {
+            return std::lexicographical_compare(lhs, lhs + kmer_words, rhs, rhs + kmer_words);
+        }
+        bool operator()(const KmerRecord &lhs, const KmerRecord &rhs) const {
+            return operator()(lhs.data, rhs.data);
+        }
+    };
+
+    typedef MMappedRecordArrayReader<seq_element_type> SampleReader;
+
+    // Position of the first record not less than the given k-mer
+    static const seq_element_type *LowerBound(const SampleReader &sample,
+                                              const seq_element_type *kmer,
+                                              const RecordLess &less) {
+        size_t stride = sample.elcnt(), lo = 0, hi = sample.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (less(sample.data() + mid * stride, kmer))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return sample.data() + lo * stride;
+    }
+
+    // Picks range boundaries as approximate quantiles of the union of samples
+    static std::vector<const seq_element_type*> SelectSplitters(
+            const std::vector<std::unique_ptr<SampleReader>> &samples,
+            size_t nranges, const RecordLess &less) {
+        std::vector<const seq_element_type*> candidates;
+        for (const auto &sample : samples) {
+            size_t cnt = sample->size();
+            for (size_t i = 1; i < nranges && cnt; ++i)
+                candidates.push_back(sample->data() + (cnt * i / nranges) * sample->elcnt());
+        }
+        std::sort(candidates.begin(), candidates.end(), less);
+
+        std::vector<const seq_element_type*> splitters;
+        for (size_t i = 1; i < nranges; ++i) {
+            if (candidates.empty())
+                break;
+            const seq_element_type *kmer = candidates[candidates.size() * i / nranges];
+            if (splitters.empty() || less(splitters.back(), kmer))
+                splitters.push_back(kmer);
+        }
+        return splitters;
+    }
+
+    // Merges the given per-sample runs (all belonging to the same k-mer range)
+    // and writes down the k-mers passing the filter together with their profiles
+    void MergeRange(const std::vector<adt::iterator_range<RecordIterator>> &runs,
+                    const RecordLess &less, size_t all_min, size_t min_mult,
+                    std::ostream &output_kmer, std::ostream &mpl_file) const {
+        size_t n = runs.size(), kmer_words = less.kmer_words;
+        adt::loser_tree<RecordIterator, RecordLess> tree(runs, less);
+        std::vector<std::pair<size_t, uint32>> hits;
+        std::vector<Mpl> profile(n, 0);
+
+        while (!tree.empty()) {
+            const seq_element_type *kmer = tree.top().data;
+            size_t total_cnt = 0;
+            hits.clear();
+            do {
+                KmerRecord rec = tree.top();
+                auto cnt = (uint32) rec.data[kmer_words];
+                hits.emplace_back(rec.sample, cnt);
+                total_cnt += cnt;
+                tree.replay();
+            } while (!tree.empty() && !less(kmer, tree.top().data));
+
+            size_t cnt_min = hits.size();
+            if (cnt_min < all_min || (cnt_min == 1 && total_cnt <= min_mult))
+                continue;
+
+            std::fill(profile.begin(), profile.end(), 0);
+            for (const auto &hit : hits)
+                profile[hit.first] = (Mpl) hit.second;
+            output_kmer.write((const char*) kmer, kmer_words * sizeof(seq_element_type));
+            mpl_file.write((const char*) profile.data(), n * sizeof(Mpl));
         }
-        seq_element_type tmp;
-        infile.read((char*) &tmp, sizeof(seq_element_type));
-        res = {seq, (uint32) tmp};
-        return true;
     }
 
     fs::TmpFile FilterCombinedKmers(fs::TmpDir workdir, const std::vector<string>& files,
-                                    size_t all_min, size_t min_mult) {
+                                    size_t all_min, size_t min_mult, size_t nthreads) {
         size_t n = files.size();
-        vector<std::unique_ptr<ifstream>> infiles;
-        infiles.reserve(n);
+        VERIFY(n > 0);
+        size_t stride = RtSeq::GetDataSize(k_) + 1;
+        vector<std::unique_ptr<SampleReader>> samples;
+        samples.reserve(n);
         for (auto fn : files) {
             INFO("Processing " << fn);
             auto parsed = ParseKmc(fn);
             auto sorted = SortKmersCountFile(parsed);
-            infiles.emplace_back(new std::ifstream(sorted));
+            samples.emplace_back(new SampleReader(sorted, stride, false));
         }
-        vector<std::pair<RtSeq, uint32>> top_kmer(n, {RtSeq(k_), 0});
-        vector<bool> alive(n, false);
 
-        for (size_t i = 0; i < n; i++) {
-            alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
+        // Split the k-mer space into ranges, which are merged independently
+        // into separate files and concatenated afterwards
+        RecordLess less{stride - 1};
+        auto splitters = SelectSplitters(samples, 4 * nthreads, less);
+        size_t nranges = splitters.size() + 1;
+        INFO("Merging " << n << " samples in " << nranges << " ranges");
+
+        std::vector<fs::TmpFile> range_kmers(nranges), range_mpls(nranges);
+        for (size_t r = 0; r < nranges; ++r) {
+            range_kmers[r] = fs::tmp::make_temp_file("kmer_range", workdir);
+            range_mpls[r] = fs::tmp::make_temp_file("mpl_range", workdir);
         }
 
-        auto kmer_file = fs::tmp::make_temp_file("kmer", workdir);
+#       pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+        for (size_t r = 0; r < nranges; ++r) {
+            std::vector<adt::iterator_range<RecordIterator>> runs;
+            runs.reserve(n);
+            for (size_t i = 0; i < n; ++i) {
+                const SampleReader &sample = *samples[i];
+                const seq_element_type *begin = (r == 0 ? sample.data() : LowerBound(sample, splitters[r - 1], less));
+                const seq_element_type *end = (r + 1 == nranges ? sample.data() + sample.size() * stride
+                                                                 : LowerBound(sample, splitters[r], less));
+                runs.push_back(adt::make_range(RecordIterator(begin, stride, i),
+                                               RecordIterator(end, stride, i)));
+            }
 
-        typedef uint16_t Mpl;
+            std::ofstream output_kmer(*range_kmers[r], std::ios::binary);
+            std::ofstream mpl_file(*range_mpls[r], std::ios::binary);
+            MergeRange(runs, less, all_min, min_mult, output_kmer, mpl_file);
+        }
+
+        auto kmer_file = fs::tmp::make_temp_file("kmer", workdir);
         std::ofstream output_kmer(*kmer_file, std::ios::binary);
         std::ofstream mpl_file(file_prefix_ + ".bpr", std::ios_base::binary);
-
-        RtSeq::less3 kmer_less;
-        while (true) {
-            boost::optional<RtSeq> min_kmer;
-            size_t cnt_min = 0, num_samples = 0;
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i]) {
-                    RtSeq& cur_kmer = top_kmer[i].first;
-                    if (!min_kmer || kmer_less(cur_kmer, *min_kmer)) {
-                        min_kmer = cur_kmer;
-                        cnt_min = 0;
-                    }
-                    if (cur_kmer == *min_kmer) {
-                        ++cnt_min;
-                    }
-                }
-            }
-            if (!min_kmer) {
-                break;
-            }
-            if (cnt_min >= all_min) {
-                std::vector<uint32> cnt_vector(n, 0);
-                size_t total_cnt = 0;
-                for (size_t i = 0; i < n; ++i) {
-                    if (alive[i] && top_kmer[i].first == *min_kmer) {
-                        auto cnt = top_kmer[i].second;
-                        cnt_vector[i] = cnt;
-                        total_cnt += cnt;
-                    }
-                }
-                if (cnt_min > 1 || total_cnt > min_mult) {
-                    min_kmer.get().BinWrite(output_kmer);
-                    for (size_t mpl : cnt_vector) {
-                        mpl_file.write(reinterpret_cast<char *>(&mpl), sizeof(Mpl));
-                    }
-                }
-            }
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i] && top_kmer[i].first == *min_kmer) {
-                    alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
-                }
-            }
+        for (size_t r = 0; r < nranges; ++r) {
+            std::ifstream kmers_in(*range_kmers[r], std::ios::binary);
+            if (kmers_in.peek() != EOF)
+                output_kmer << kmers_in.rdbuf();
+            std::ifstream mpls_in(*range_mpls[r], std::ios::binary);
+            if (mpls_in.peek() != EOF)
+                mpl_file << mpls_in.rdbuf();
         }
+
         return kmer_file;
     }
 
@@ -188,7 +284,7 @@ public:
     void CombineMultiplicities(const vector<string>& input_files, size_t min_samples,
                                size_t min_mult, const string& tmpdir, size_t nthreads = 1) {
         auto workdir = fs::tmp::make_temp_dir(tmpdir, "kmidx");
-        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult);
+        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult, nthreads);
         BuildKmerIndex(workdir, kmer_file, input_files.size(), nthreads);
     }
 private:
@@ -58,7 +58,7 @@ int main(int argc, char** argv) {
     string saves_path, contigs_path, splits_path, annotation_path, bins_file;
     vector<string> sample_names, left_reads, right_reads;
     string out_root, edges_dump, propagation_dump;
-    size_t length_threshold;
+    size_t length_threshold, nthreads;
     bool no_binning;
     try {
         GetOpt_pp ops(argc, argv);
@@ -76,6 +76,7 @@ int main(int argc, char** argv) {
             >> Option('o', "out", out_root, "")
             >> Option('p', "dump-annotation", propagation_dump, "")
             >> Option('e', "dump-edges", edges_dump, "")
+            >> Option('j', "threads", nthreads, (size_t)1)
         ;
         if (sample_names.empty() == left_reads.empty()  && //All options of this group
             left_reads.empty()   == right_reads.empty() && //must simultaneously present or not
@@ -89,7 +90,7 @@ int main(int argc, char** argv) {
         cerr << "Usage: prop_binning -k <K> -s <saves path> -c <contigs path> -f <splits path> "
                 "-a <binning annotation> [-t <length threshold>] [-b <bins to propagate>] "
                 "[-n <sample names> -l <left reads> -r <right reads> -o <reads output root>] "
-                "[-p <propagation info dump>] [-e <propagated edges dump>]"  << endl;
+                "[-p <propagation info dump>] [-e <propagated edges dump>] [-j <threads>]"  << endl;
         exit(1);
     }
 
@@ -146,7 +147,7 @@ int main(int argc, char** argv) {
     if (!no_binning) {
         INFO("Binning reads into " << out_root);
         for (size_t i = 0; i < sample_names.size(); ++i)
-            BinReads(gp, out_root, sample_names[i], left_reads[i], right_reads[i], edge_annotation, bins_of_interest);
+            BinReads(gp, out_root, sample_names[i], left_reads[i], right_reads[i], edge_annotation, bins_of_interest, nthreads);
     }
     return 0;
 }
@@ -8,6 +8,7 @@
 #include "utils/stl_utils.hpp"
 #include "utils/logger/log_writers.hpp"
 #include "io/reads/file_reader.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "read_binning.hpp"
 
 namespace debruijn_graph {
@@ -16,41 +17,87 @@ std::set<bin_id> ContigBinner::RelevantBins(const io::SingleRead& r) const {
     return edge_annotation_.RelevantBins(mapper_->MapRead(r).simple_path());
 }
 
-void ContigBinner::Init(bin_id bin) {
+std::set<bin_id> ContigBinner::RelevantBins(const io::PairedRead& r) const {
+    std::set<bin_id> bins = RelevantBins(r.first());
+    utils::insert_all(bins, RelevantBins(r.second()));
+    return bins;
+}
+
+ContigBinner::BinOutput& ContigBinner::Init(bin_id bin) {
     std::string out_dir = out_root_ + "/" + bin + "/";
     fs::make_dirs(out_dir);
-    out_streams_.emplace(bin, std::make_unique<ContigBinner::Stream>(
+    auto& out = out_streams_[bin];
+    out.stream = std::make_unique<ContigBinner::Stream>(
         out_dir + sample_name_ + "_1.fastq.gz",
-        out_dir + sample_name_ + "_2.fastq.gz")
-    );
+        out_dir + sample_name_ + "_2.fastq.gz");
+    return out;
+}
+
+void ContigBinner::Write(const bin_id& bin, std::vector<io::PairedRead> reads) {
+    auto it = out_streams_.find(bin);
+    BinOutput& out = (it != out_streams_.end() ? it->second : Init(bin));
+    if (out.pending.valid())
+        out.pending.wait();
+
+    Stream* stream = out.stream.get();
+    out.pending = writers_.run([stream, reads = std::move(reads)] {
+        for (const auto& read : reads)
+            *stream << read;
+    });
+}
+
+void ContigBinner::WaitWriters() {
+    for (auto& entry : out_streams_) {
+        if (entry.second.pending.valid())
+            entry.second.pending.wait();
+    }
 }
 
 void ContigBinner::Run(io::PairedStream& paired_reads) {
-    io::PairedRead paired_read;
+    const size_t BATCH_SIZE = 100000;
+    std::vector<io::PairedRead> batch;
+    std::vector<std::set<bin_id>> bins;
+    batch.reserve(BATCH_SIZE);
+
     while (!paired_reads.eof()) {
-        paired_reads >> paired_read;
-        std::set<bin_id> bins;
-        utils::insert_all(bins, RelevantBins(paired_read.first()));
-        utils::insert_all(bins, RelevantBins(paired_read.second()));
-        for (const auto& bin : bins) {
-            if (bins_of_interest_.size() && !bins_of_interest_.count(bin)) {
-                INFO(bin << " was excluded from read binning");
-                continue;
-            }
-            if (!out_streams_.count(bin)) {
-                Init(bin);
+        batch.clear();
+        io::PairedRead paired_read;
+        while (batch.size() < BATCH_SIZE && !paired_reads.eof()) {
+            paired_reads >> paired_read;
+            batch.push_back(std::move(paired_read));
+        }
+
+        // Map the batch in parallel, while the previous one is still being
+        // compressed by the writers
+        bins.resize(batch.size());
+#       pragma omp parallel for schedule(guided) num_threads(nthreads_)
+        for (size_t i = 0; i < batch.size(); ++i)
+            bins[i] = RelevantBins(batch[i]);
+
+        std::map<bin_id, std::vector<io::PairedRead>> bin_reads;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            for (const auto& bin : bins[i]) {
+                if (bins_of_interest_.size() && !bins_of_interest_.count(bin)) {
+                    INFO(bin << " was excluded from read binning");
+                    continue;
+                }
+                bin_reads[bin].push_back(batch[i]);
             }
-            *out_streams_[bin] << paired_read;
         }
+
+        for (auto& entry : bin_reads)
+            Write(entry.first, std::move(entry.second));
     }
+    WaitWriters();
 }
 
 void BinReads(const GraphPack& gp, const std::string& out_root,
               const std::string& sample,
               const std::string& left_reads, const std::string& right_reads,
               const EdgeAnnotation& edge_annotation,
-              const std::vector<std::string>& bins_of_interest) {
-    ContigBinner binner(gp, edge_annotation, out_root, sample, bins_of_interest);
+              const std::vector<std::string>& bins_of_interest,
+              size_t nthreads) {
+    ContigBinner binner(gp, edge_annotation, out_root, sample, bins_of_interest, nthreads);
     INFO("Initializing binner for " << sample);
     auto paired_stream = io::PairedEasyStream(left_reads, right_reads, false, 0);
     INFO("Running binner on " << left_reads << " and " << right_reads);
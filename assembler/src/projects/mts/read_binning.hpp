@@ -11,6 +11,8 @@
 #include "io/reads/io_helper.hpp"
 #include "io/reads/osequencestream.hpp"
 
+#include "threadpool/threadpool.hpp"
+
 namespace debruijn_graph {
 
 class ContigBinner {
@@ -20,29 +22,44 @@ class ContigBinner {
     std::string sample_name_;
     std::shared_ptr<SequenceMapper<Graph>> mapper_;
     std::set<std::string> bins_of_interest_;
+    size_t nthreads_;
 
     typedef io::OPairedReadStream<ogzstream, io::FastqWriter> Stream;
-    std::map<bin_id, std::unique_ptr<Stream>> out_streams_;
+    // Reads of a bin are compressed by the writer pool, at most one batch
+    // per bin is in flight, so the order of reads in a bin is preserved
+    struct BinOutput {
+        std::unique_ptr<Stream> stream;
+        std::future<void> pending;
+    };
+    std::map<bin_id, BinOutput> out_streams_;
+    ThreadPool::ThreadPool writers_;
 
     std::set<bin_id> RelevantBins(const io::SingleRead& r) const;
+    std::set<bin_id> RelevantBins(const io::PairedRead& r) const;
 
-    void Init(bin_id bin);
+    BinOutput& Init(bin_id bin);
+    void Write(const bin_id& bin, std::vector<io::PairedRead> reads);
+    void WaitWriters();
 
 public:
     ContigBinner(const GraphPack& gp,
                  const EdgeAnnotation& edge_annotation,
                  const std::string& out_root,
                  const std::string& sample_name,
-                 const std::vector<std::string>& bins_of_interest = {}) :
+                 const std::vector<std::string>& bins_of_interest = {},
+                 size_t nthreads = 1) :
                      gp_(gp),
                      edge_annotation_(edge_annotation),
                      out_root_(out_root),
                      sample_name_(sample_name),
                      mapper_(MapperInstance(gp)),
-                     bins_of_interest_(bins_of_interest.begin(), bins_of_interest.end()) {
+                     bins_of_interest_(bins_of_interest.begin(), bins_of_interest.end()),
+                     nthreads_(nthreads),
+                     writers_(nthreads) {
     }
 
     ~ContigBinner() {
+        WaitWriters();
         out_streams_.clear();
     }
 
@@ -53,6 +70,7 @@ void BinReads(const GraphPack& gp, const std::string& out_root,
              const std::string& sample,
              const std::string& left_reads, const std::string& right_reads,
              const EdgeAnnotation& edge_annotation,
-             const std::vector<std::string>& bins_of_interest);
+             const std::vector<std::string>& bins_of_interest,
+             size_t nthreads = 1);
 
 }
@@ -61,9 +61,13 @@ private:
 
         omnigraph::IterationHelper<Graph, EdgeId> edges(graph_);
         auto ranges = edges.Ranges(nthreads);
-#pragma omp parallel for
+        // Every tip edge belongs to a single range and every edge leads to at
+        // most one tip, so the per-range maps are disjoint and can be simply
+        // concatenated afterwards
+        std::vector<TipMap> local_out_tip_maps(ranges.size());
+#pragma omp parallel for schedule(dynamic, 1)
         for (size_t i = 0; i < ranges.size(); ++i) {
-            TipMap local_out_tip_map;
+            TipMap &local_out_tip_map = local_out_tip_maps[i];
             for (EdgeId edge : ranges[i]) {
                 if (!graph_.IsDeadEnd(graph_.EdgeEnd(edge)))
                     continue;
@@ -87,15 +91,19 @@ private:
                     }
                 }
             }
+        }
 
-#pragma omp critical
-            {
-                OutTipMap.insert(std::make_move_iterator(local_out_tip_map.begin()), std::make_move_iterator(local_out_tip_map.end()));
-            }
+        size_t total = 0;
+        for (const auto &local_out_tip_map : local_out_tip_maps)
+            total += local_out_tip_map.size();
+        OutTipMap.reserve(total);
+        for (auto &local_out_tip_map : local_out_tip_maps) {
+            OutTipMap.insert(local_out_tip_map.begin(), local_out_tip_map.end());
+            TipMap().swap(local_out_tip_map);
         }
 
         size_t out_length =
-                std::accumulate(OutTipMap.begin(), OutTipMap.end(), 0,
+                std::accumulate(OutTipMap.begin(), OutTipMap.end(), size_t(0),
                                 [this](size_t val, const std::pair<EdgeId, EdgeId> &p) { return val + graph_.length(p.first); });
 
         INFO("Total edges in tip neighborhood: " << OutTipMap.size() << " out of " << graph_.e_size() << ", length: " << out_length);
@@ -175,6 +183,9 @@ class GapCloser {
     const size_t min_intersection_;
     const size_t hamming_dist_bound_;
     const omnigraph::de::DEWeight weight_threshold_;
+    // Edges changed by the closed gaps and edges deleted by tip corrections
+    phmap::flat_hash_set<EdgeId> touched_;
+    phmap::flat_hash_set<EdgeId> removed_;
 
     std::vector<size_t> DiffPos(const Sequence &s1, const Sequence &s2) const {
         VERIFY(s1.size() == s2.size());
@@ -234,6 +245,8 @@ class GapCloser {
     }
 
     void CorrectLeft(EdgeId first, EdgeId second, int overlap, const MismatchPos &diff_pos) {
+        removed_.insert(first);
+        removed_.insert(g_.conjugate(first));
         DEBUG("Can correct first with sequence from second.");
         Sequence new_sequence = g_.EdgeNucls(first).Subseq(g_.length(first) - overlap + diff_pos.front(),
                                                            g_.length(first) + k_ - overlap)
@@ -252,6 +265,8 @@ class GapCloser {
     }
 
     void CorrectRight(EdgeId first, EdgeId second, int overlap, const MismatchPos &diff_pos) {
+        removed_.insert(second);
+        removed_.insert(g_.conjugate(second));
         DEBUG("Can correct second with sequence from first.");
         Sequence new_sequence =
                 g_.EdgeNucls(first).Last(k_) + g_.EdgeNucls(second).Subseq(overlap, diff_pos.back() + 1 + k_);
@@ -302,14 +317,16 @@ class GapCloser {
         return true;
     }
 
-    bool ProcessPair(EdgeId first, EdgeId second) {
+    // Finds the overlap the gap between two tips should be closed with.
+    // Returns -1 if the tips cannot be joined. Does not modify the graph.
+    int FindOverlap(EdgeId first, EdgeId second, size_t &hamming_dist) const {
         TRACE("Processing edges " << g_.str(first) << " and " << g_.str(second));
         TRACE("first " << g_.EdgeNucls(first) << " second " << g_.EdgeNucls(second));
 
         if (cfg::get().avoid_rc_connections &&
             (first == g_.conjugate(second) || first == second)) {
             DEBUG("Trying to join conjugate edges " << g_.int_id(first));
-            return false;
+            return -1;
         }
 
         Sequence seq1 = g_.EdgeNucls(first), seq2 = g_.EdgeNucls(second);
@@ -333,7 +350,7 @@ class GapCloser {
                 double ratio = 0.8 + 0.2 * double(gap - 1)/double(k_-min_intersection_-1);
                 if (math::gr(double(curm), ratio * double(overlap))) {
                     DEBUG("Disregard low-complexity overlap: " << oseq);
-                    return false;
+                    return -1;
                 }
             }
 
@@ -344,26 +361,88 @@ class GapCloser {
             //                << seq1.Subseq(seq1.size() - k).str() << "  "
             //                << seq2.Subseq(0, k).str());
 
-            if (hamming_distance > 0) {
-                return HandlePositiveHammingDistanceCase(first, second, overlap);
-            } else {
-                return HandleSimpleCase(first, second, overlap);
-            }
+            hamming_dist = hamming_distance;
+            return overlap;
+        }
+        return -1;
+    }
+
+    bool CloseGap(EdgeId first, EdgeId second, int overlap, size_t hamming_dist) {
+        bool closed = (hamming_dist > 0 ?
+                       HandlePositiveHammingDistanceCase(first, second, overlap) :
+                       HandleSimpleCase(first, second, overlap));
+        if (closed) {
+            for (EdgeId e : { first, second, g_.conjugate(first), g_.conjugate(second) })
+                touched_.insert(e);
+        }
+        return closed;
+    }
+
+    bool ProcessPair(EdgeId first, EdgeId second) {
+        size_t hamming_dist = 0;
+        int overlap = FindOverlap(first, second, hamming_dist);
+        return overlap >= 0 && CloseGap(first, second, overlap, hamming_dist);
+    }
+
+    struct GapCandidate {
+        EdgeId second;
+        // Number of tip pair points with enough weight
+        size_t points;
+        int overlap;
+        size_t hamming_dist;
+    };
+
+    // Collects the tip pairs to check for the given out-tip along with their
+    // overlaps, in the order of the paired index
+    std::vector<GapCandidate> CollectCandidates(EdgeId first_edge) const {
+        std::vector<GapCandidate> candidates;
+        if (!g_.IsDeadEnd(g_.EdgeEnd(first_edge)))
+            return candidates;
+
+        for (auto i : tips_paired_idx_.Get(first_edge)) {
+            EdgeId second_edge = i.first;
+            if (first_edge == second_edge || !g_.IsDeadStart(g_.EdgeStart(second_edge)))
+                continue;
+
+            size_t points = 0;
+            for (auto point : i.second)
+                points += !math::ls(point.weight, weight_threshold_);
+            if (!points)
+                continue;
+
+            GapCandidate candidate{second_edge, points, -1, 0};
+            candidate.overlap = FindOverlap(first_edge, second_edge, candidate.hamming_dist);
+            candidates.push_back(candidate);
         }
-        return false;
+        return candidates;
     }
 
 public:
-    //TODO extract methods
     void CloseShortGaps() {
         INFO("Closing short gaps");
+        std::vector<EdgeId> edges;
+        for (auto edge = g_.SmartEdgeBegin(); !edge.IsEnd(); ++edge)
+            edges.push_back(*edge);
+
+        // Overlap search is the expensive part and does not touch the graph,
+        // so do it for all the candidate tip pairs in parallel
+        std::vector<std::vector<GapCandidate>> candidates(edges.size());
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i)
+            candidates[i] = CollectCandidates(edges[i]);
+
+        // Apply the closures serially in the original order. Pairs involving
+        // edges changed by earlier closures are re-evaluated from scratch.
         size_t gaps_filled = 0;
         size_t gaps_checked = 0;
-        for (auto edge = g_.SmartEdgeBegin(); !edge.IsEnd(); ++edge) {
-            EdgeId first_edge = *edge;
-            for (auto i : tips_paired_idx_.Get(first_edge)) {
-                EdgeId second_edge = i.first;
-                if (first_edge == second_edge)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            EdgeId first_edge = edges[i];
+            if (removed_.count(first_edge))
+                continue;
+
+            for (const auto &candidate : candidates[i]) {
+                EdgeId second_edge = candidate.second;
+                if (removed_.count(second_edge))
                     continue;
 
                 if (!g_.IsDeadEnd(g_.EdgeEnd(first_edge)) || !g_.IsDeadStart(g_.EdgeStart(second_edge))) {
@@ -371,20 +450,20 @@ public:
                     continue;
                 }
 
-                bool closed = false;
-                for (auto point : i.second) {
-                    if (math::ls(point.weight, weight_threshold_))
-                        continue;
+                bool closed;
+                if (touched_.count(first_edge) || touched_.count(second_edge))
+                    closed = ProcessPair(first_edge, second_edge);
+                else
+                    closed = (candidate.overlap >= 0 &&
+                              CloseGap(first_edge, second_edge, candidate.overlap, candidate.hamming_dist));
 
+                // Every point of the pair used to be checked until success
+                if (closed) {
                     ++gaps_checked;
-                    closed = ProcessPair(first_edge, second_edge);
-                    if (closed) {
-                        ++gaps_filled;
-                        break;
-                    }
-                }
-                if (closed)
+                    ++gaps_filled;
                     break;
+                }
+                gaps_checked += candidate.points;
             } // second edge
         } // first edge
 
@@ -13,8 +13,12 @@
 #include "ConsensusCore/Poa/PoaConsensus.hpp"
 #include "gap_closing.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 #include <algorithm>
 #include <fstream>
+#include <memory>
+#include <numeric>
 
 namespace debruijn_graph {
 namespace gap_closing {
@@ -303,9 +307,10 @@ public:
 };
 
 inline std::string PoaConsensus(const std::vector<std::string> &gap_seqs) {
-    const ConsensusCore::PoaConsensus* pc = ConsensusCore::PoaConsensus::FindConsensus(
+    // FindConsensus hands over the ownership of the whole POA graph
+    std::unique_ptr<const ConsensusCore::PoaConsensus> pc(ConsensusCore::PoaConsensus::FindConsensus(
             gap_seqs,
-            ConsensusCore::PoaConfig::GLOBAL_ALIGNMENT);
+            ConsensusCore::PoaConfig::GLOBAL_ALIGNMENT));
     return pc->Sequence();
 }
 
@@ -316,28 +321,36 @@ inline std::string TrivialConsenus(const std::vector<std::string> &gap_seqs, siz
 
 /*Keys are actual edges of the graph, values are original edges*/
 /*In general many-to-many relationship*/
+/*Original edges are not stored at all until they are changed*/
 class EdgeFateTracker : omnigraph::GraphActionHandler<Graph> {
-    std::map<EdgeId, std::set<EdgeId>> storage_;
+    //Sorted original edges of every novel edge
+    typedef std::vector<EdgeId> Origins;
+    phmap::flat_hash_map<EdgeId, Origins> storage_;
 
-    void FillRelevant(EdgeId e, std::set<EdgeId> &relevant) const {
+    void FillRelevant(EdgeId e, Origins &relevant) const {
         auto it = storage_.find(e);
         if (it != storage_.end()) {
             //one of novel edges
-            relevant.insert(it->second.begin(), it->second.end());
+            relevant.insert(relevant.end(), it->second.begin(), it->second.end());
         } else {
             //one of original edges
-            relevant.insert(e);
+            relevant.push_back(e);
         }
     }
 
+    static void Normalize(Origins &relevant) {
+        std::sort(relevant.begin(), relevant.end());
+        relevant.erase(std::unique(relevant.begin(), relevant.end()), relevant.end());
+        relevant.shrink_to_fit();
+    }
+
 public:
     EdgeFateTracker(const Graph& g) :
             omnigraph::GraphActionHandler<Graph>(g, "EdgeFateTracker") {
     }
 
     void HandleAdd(EdgeId e) override {
-        if (!storage_.count(e))
-            storage_[e] = {};
+        storage_.emplace(e, Origins());
     }
 
     void HandleDelete(EdgeId e) override {
@@ -345,11 +358,12 @@ public:
     }
 
     void HandleMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) override {
-        std::set<EdgeId> relevant_records;
+        Origins relevant_records;
         for (EdgeId e : old_edges) {
             FillRelevant(e, relevant_records);
         }
-        storage_[new_edge] = relevant_records;
+        Normalize(relevant_records);
+        storage_[new_edge] = std::move(relevant_records);
     }
 
     void HandleGlue(EdgeId /*new_edge*/, EdgeId /*edge1*/, EdgeId /*edge2*/) override {
@@ -357,10 +371,10 @@ public:
     }
 
     void HandleSplit(EdgeId old_edge, EdgeId new_edge_1, EdgeId new_edge_2) override {
-        std::set<EdgeId> relevant_records;
+        Origins relevant_records;
         FillRelevant(old_edge, relevant_records);
         storage_[new_edge_1] = relevant_records;
-        storage_[new_edge_2] = relevant_records;
+        storage_[new_edge_2] = std::move(relevant_records);
     }
 
     std::map<EdgeId, EdgeId> Old2NewMapping() const {
@@ -562,10 +576,8 @@ private:
     GapDescription ConstructConsensus(EdgeId left, EdgeId right, size_t left_trim, size_t right_trim,
                                       const std::vector<std::string> &gap_variants) const {
         DEBUG(gap_variants.size() << " gap closing variants, lengths: " << PrintLengths(gap_variants));
-        DEBUG("var size original " << gap_variants.size());
-        auto new_gap_variants(gap_variants);
-        new_gap_variants.resize(std::min(max_consensus_reads_, gap_variants.size()));
-        auto s = consensus_(new_gap_variants);
+        VERIFY(gap_variants.size() <= max_consensus_reads_);
+        auto s = consensus_(gap_variants);
         DEBUG("consenus for " << g_.int_id(left)
                               << " and " << g_.int_id(right)
                               << " found: '" << s << "'");
@@ -575,7 +587,9 @@ private:
     }
 
     //all gaps guaranteed to correspond to a single edge pair
-    GapInfos PadGaps(gap_info_it start, gap_info_it end) const {
+    //only the first max_count padded gaps are constructed, total is set to the
+    //number of gaps that would be padded without the limit
+    GapInfos PadGaps(gap_info_it start, gap_info_it end, size_t max_count, size_t &total) const {
         size_t start_trim = 0;
         size_t end_trim = 0;
         size_t long_seqs = 0;
@@ -610,12 +624,16 @@ private:
         }
 
         GapInfos answer;
+        total = 0;
         for (auto it = start; it != end; ++it) {
             const auto& gap = *it;
 
             if (exclude_long_seqs && gap.filling_seq().size() > long_seq_limit_)
                 continue;
 
+            if (total++ >= max_count)
+                continue;
+
             size_t start_nucl_size = g_.length(gap.left()) + g_.k();
             auto s = g_.EdgeNucls(gap.left()).Subseq(start_nucl_size - start_trim, start_nucl_size - gap.left_trim()).str();
             s += gap.filling_seq().str();
@@ -632,9 +650,11 @@ private:
         //low weight connections filtered earlier
         VERIFY(cur_len >= min_weight_);
 
-        auto padded_gaps = PadGaps(start_it, end_it);
+        //only the variants used for consensus are materialized
+        size_t padded_cnt = 0;
+        auto padded_gaps = PadGaps(start_it, end_it, max_consensus_reads_, padded_cnt);
         //all start and end positions are equal here
-        if (padded_gaps.size() < min_weight_) {
+        if (padded_cnt < min_weight_) {
             DEBUG("Connection weight too low after padding");
             return INVALID_GAP;
         }
@@ -680,23 +700,46 @@ private:
         return INVALID_GAP;
     }
 
-    std::vector<GapDescription> ConstructConsensus() const {
-        std::vector<std::vector<GapDescription>> closures_by_thread(omp_get_max_threads());
-
-        # pragma omp parallel for
-        for (size_t i = 0; i < storage_.size(); i++) {
-            EdgeId e = storage_[i];
-            size_t thread_num = omp_get_thread_num();
-            GapDescription gap = ConstructConsensus(e);
-            if (gap != INVALID_GAP) {
-                closures_by_thread[thread_num].push_back(gap);
+    //rough estimate of the consensus construction time: POA is quadratic in
+    //the sequence length and only max_consensus_reads_ sequences per edge pair
+    //are aligned
+    size_t ConsensusCost(EdgeId e) const {
+        size_t cost = 0;
+        for (const auto& edge_pair_gaps : storage_.EdgePairGaps(utils::get(storage_.inner_index(), e))) {
+            size_t cnt = 0;
+            for (auto it = edge_pair_gaps.first; it != edge_pair_gaps.second && cnt < max_consensus_reads_; ++it, ++cnt) {
+                size_t len = it->filling_seq().size() + 1;
+                cost += len * len;
             }
         }
+        return cost;
+    }
+
+    std::vector<GapDescription> ConstructConsensus() const {
+        size_t n = storage_.size();
+        std::vector<size_t> costs(n);
+        # pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < n; i++)
+            costs[i] = ConsensusCost(storage_[i]);
+
+        //the most expensive edges go first, so the long ones do not end up
+        //in the tail of the loop
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return costs[a] > costs[b]; });
+
+        std::vector<GapDescription> edge_closures(n, INVALID_GAP);
+        # pragma omp parallel for schedule(dynamic, 1)
+        for (size_t j = 0; j < n; j++) {
+            size_t i = order[j];
+            edge_closures[i] = ConstructConsensus(storage_[i]);
+        }
 
         std::vector<GapDescription> closures;
-        for (auto& new_per_thread : closures_by_thread) {
-            std::copy(new_per_thread.begin(), new_per_thread.end(), std::back_inserter(closures));
-            new_per_thread.clear();
+        for (auto& gap : edge_closures) {
+            if (gap != INVALID_GAP)
+                closures.push_back(std::move(gap));
         }
         return closures;
     }
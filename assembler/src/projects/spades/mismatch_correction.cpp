@@ -19,6 +19,8 @@
 #include "adt/flat_set.hpp"
 #include <parallel_hashmap/phmap.h>
 
+#include <atomic>
+
 template <typename Iter>
 std::vector<Iter> split_iterator(size_t chunks, Iter b, Iter e, size_t n) {
     std::vector<Iter> result(chunks + 1, e);
@@ -66,46 +68,46 @@ struct NuclCount {
     }
 };
 
-struct MismatchEdgeInfo {
-    NuclCount operator[](size_t i) const {
-        auto it = info_.find(uint32_t(i));
-        if (it == info_.end())
-            return NuclCount();
-        else
-            return it->second;
-    }
+// Nucleotide counts at the candidate positions of a single edge. Positions are
+// sorted, the counts of the i-th one are stored in counts_[4 * i..4 * i + 4).
+class MismatchEdgeInfo {
+    const uint32_t *positions_;
+    const std::atomic<uint32_t> *counts_;
+    size_t size_;
 
-    void operator+=(const MismatchEdgeInfo &other) {
-        for (const auto &entry : other.info_) {
-            info_[entry.first] += entry.second;
-        }
-    }
+public:
+    MismatchEdgeInfo(const uint32_t *positions = nullptr,
+                     const std::atomic<uint32_t> *counts = nullptr,
+                     size_t size = 0)
+            : positions_(positions), counts_(counts), size_(size) {}
 
-    void increment(size_t position, size_t nucl) {
-        info_[uint32_t(position)][nucl] += 1;
-    }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
 
-    void ClearValues() {
-        for (auto &kv : info_) {
-            kv.second = NuclCount();
-        }
-    }
+    size_t position(size_t i) const { return positions_[i]; }
 
-public:
-    phmap::flat_hash_map<uint32_t, NuclCount> info_;
+    NuclCount counts(size_t i) const {
+        NuclCount res;
+        for (size_t nucl = 0; nucl < 4; ++nucl)
+            res[nucl] = counts_[4 * i + nucl].load(std::memory_order_relaxed);
+        return res;
+    }
 };
 
 class MismatchStatistics : public SequenceMapperListener {
 private:
     typedef Graph::EdgeId EdgeId;
-    typedef phmap::node_hash_map<EdgeId, MismatchEdgeInfo> InnerMismatchStatistics;
-    typedef typename InnerMismatchStatistics::const_iterator const_iterator;
-    InnerMismatchStatistics statistics_;
-    std::vector<InnerMismatchStatistics> statistics_buffers_;
-
     typedef phmap::node_hash_map<EdgeId, adt::flat_set<uint32_t>> MismatchCandidates;
     MismatchCandidates candidates_;
 
+    // Candidate positions of all the edges are numbered densely: positions of
+    // an edge occupy a contiguous range of positions_ and every position owns
+    // four counters in counts_. Counters are updated concurrently right from
+    // the mapping threads, so there are no per-thread buffers to merge.
+    phmap::flat_hash_map<EdgeId, std::pair<size_t, size_t>> edge_ranges_;
+    std::vector<uint32_t> positions_;
+    std::unique_ptr<std::atomic<uint32_t>[]> counts_;
+
     const Graph &g_;
 
     template <typename Iter>
@@ -194,8 +196,28 @@ private:
         }
     }
 
+    void AllocateCounters() {
+        size_t total = 0;
+        for (const auto &candidate : candidates_)
+            total += candidate.second.size();
+
+        positions_.reserve(total);
+        edge_ranges_.reserve(candidates_.size());
+        for (const auto &candidate : candidates_) {
+            size_t start = positions_.size();
+            positions_.insert(positions_.end(), candidate.second.begin(), candidate.second.end());
+            edge_ranges_.emplace(candidate.first, std::make_pair(start, positions_.size()));
+        }
+        candidates_.clear();
+
+        counts_.reset(new std::atomic<uint32_t>[4 * total]);
+#       pragma omp parallel for
+        for (size_t i = 0; i < 4 * total; ++i)
+            counts_[i].store(0, std::memory_order_relaxed);
+    }
+
     template <typename Read>
-    void ProcessSingleReadImpl(size_t thread_index, const Read& read, const MappingPath<EdgeId> &path) {
+    void ProcessSingleReadImpl(size_t /* thread_index */, const Read& read, const MappingPath<EdgeId> &path) {
         // VERIFY(path.size() <= 1);
         if (path.size() != 1)  // TODO Use only_simple feature
             return;
@@ -203,13 +225,12 @@ private:
         EdgeId e = path[0].first;
         MappingRange mr = path[0].second;
         const Sequence &s_read = read.sequence();
-        auto &buffer = statistics_buffers_[thread_index];
 
         if (mr.initial_range.size() != mr.mapped_range.size())
             return;
 
-        auto it = candidates_.find(e);
-        if (it == candidates_.end())
+        auto it = edge_ranges_.find(e);
+        if (it == edge_ranges_.end())
             return;
 
         const Sequence &s_edge = g_.EdgeNucls(e);
@@ -224,23 +245,14 @@ private:
             return;
 
         TRACE("statistics might be changing");
-        for (size_t i = 0; i < len; i++) {
-            size_t pos = mr.mapped_range.start_pos + i;
-            if (pos > std::numeric_limits<uint32_t>::max())
-                continue;
-
-            if (!it->second.count(uint32_t(pos)))
-                continue;
-
-            char nucl_code = s_read[mr.initial_range.start_pos + i];
-            buffer[e].increment(pos, nucl_code);
-        }
-    }
-
-    void Merge(InnerMismatchStatistics &other_statistics) {
-        for (auto &e_info : other_statistics) {
-            statistics_[e_info.first] += e_info.second;
-            e_info.second.ClearValues();
+        // Visit only the candidate positions covered by the read
+        size_t start = mr.mapped_range.start_pos;
+        const uint32_t *positions = positions_.data();
+        const uint32_t *pos_it = std::lower_bound(positions + it->second.first,
+                                                  positions + it->second.second, start);
+        for (; pos_it != positions + it->second.second && *pos_it < start + len; ++pos_it) {
+            char nucl_code = s_read[mr.initial_range.start_pos + (*pos_it - start)];
+            counts_[4 * (pos_it - positions) + nucl_code].fetch_add(1, std::memory_order_relaxed);
         }
     }
 
@@ -248,15 +260,7 @@ public:
     MismatchStatistics(const GraphPack &gp):
             g_(gp.get<Graph>()) {
         CollectPotentialMismatches(gp);
-    }
-
-    void StartProcessLibrary(size_t threads_count) override {
-        statistics_buffers_.clear();
-        statistics_buffers_.resize(threads_count, statistics_);
-    }
-
-    void StopProcessLibrary() override {
-        statistics_buffers_.clear();
+        AllocateCounters();
     }
 
     void ProcessSingleRead(size_t thread_index, const io::SingleReadSeq &read, const MappingPath<EdgeId> &path) override {
@@ -267,20 +271,14 @@ public:
         ProcessSingleReadImpl(thread_index, read, path);
     }
 
-    void MergeBuffer(size_t thread_index) override {
-        Merge(statistics_buffers_[thread_index]);
-    }
-
-    const_iterator begin() const {
-        return statistics_.begin();
-    }
-
-    const_iterator end() const {
-        return statistics_.end();
-    }
+    MismatchEdgeInfo operator[](EdgeId edge) const {
+        auto it = edge_ranges_.find(edge);
+        if (it == edge_ranges_.end())
+            return MismatchEdgeInfo();
 
-    const_iterator find(const EdgeId &edge) const {
-        return statistics_.find(edge);
+        size_t start = it->second.first;
+        return MismatchEdgeInfo(positions_.data() + start, counts_.get() + 4 * start,
+                                it->second.second - start);
     }
 };
 
@@ -336,9 +334,18 @@ private:
     std::vector<std::pair<size_t, char>> FindMismatches(EdgeId edge, const MismatchEdgeInfo &statistics) const {
         std::vector<std::pair<size_t, char>> to_correct;
         const Sequence &s_edge = graph_.EdgeNucls(edge);
-        for (size_t i = k_; i < graph_.length(edge); i++) {
+        // Positions without statistics never get corrected, so it is enough
+        // to look at the candidates only
+        size_t next_allowed = k_;
+        for (size_t idx = 0; idx < statistics.size(); ++idx) {
+            size_t i = statistics.position(idx);
+            if (i < next_allowed)
+                continue;
+            if (i >= graph_.length(edge))
+                break;
+
             size_t cur_best = 0;
-            NuclCount nc = statistics[i];
+            NuclCount nc = statistics.counts(idx);
             for (size_t j = 1; j < 4; j++) {
                 if (nc[j] > nc[cur_best]) {
                     cur_best = j;
@@ -347,9 +354,8 @@ private:
             char nucl_code = s_edge[i];
             if ((double) nc[cur_best] > relative_threshold_ * (double) nc[nucl_code] + 1.) {
                 to_correct.emplace_back(i, cur_best);
-                i += k_;
+                next_allowed = i + k_ + 1;
             }
-
         }
         return to_correct;
     }
@@ -384,12 +390,12 @@ private:
         for (EdgeId e : conjugate_fix) {
             DEBUG("processing edge" << graph_.int_id(e));
 
-            auto stat_it = statistics.find(e);
-            if (stat_it == statistics.end())
+            MismatchEdgeInfo edge_statistics = statistics[e];
+            if (edge_statistics.empty())
                 continue;
 
             if (!graph_.RelatedVertices(graph_.EdgeStart(e), graph_.EdgeEnd(e))) {
-                res += CorrectEdge(e, stat_it->second);
+                res += CorrectEdge(e, edge_statistics);
             }
         }
         INFO("All edges processed");
@@ -226,6 +226,7 @@ void assemble_genome() {
 
     StageManager SPAdes(SavesPolicy(cfg::get().checkpoints,
                                     cfg::get().output_saves, cfg::get().load_from));
+    SPAdes.enable_resource_report(fs::append_path(cfg::get().output_dir, "resource_report.json"));
 
     bool two_step_rr = cfg::get().two_step_rr && cfg::get().rr_enable;
     INFO("Two-step repeat resolution " << (two_step_rr ? "enabled" : "disabled"));
@@ -238,6 +239,10 @@ void assemble_genome() {
                                             cfg::get().flanking_range,
                                             cfg::get().pos.max_mapping_gap,
                                             cfg::get().pos.max_gap_diff);
+    if (cfg::get().compact_sequences) {
+        INFO("Edge sequences will be compacted into arena between stages");
+        conj_gp.get_mutable<debruijn_graph::Graph>().EnableSequenceArena();
+    }
     if (cfg::get().need_mapping) {
         INFO("Will need read mapping, kmer mapper will be attached");
         conj_gp.get_mutable<debruijn_graph::KmerMapper<debruijn_graph::Graph>>().Attach();
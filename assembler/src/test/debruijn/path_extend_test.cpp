@@ -7,11 +7,16 @@
 
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/pe_utils.hpp"
+#include "modules/path_extend/paired_library.hpp"
+#include "modules/path_extend/ideal_pair_info.hpp"
+#include "modules/path_extend/seed_container.hpp"
 
 #include "graphio.hpp"
 
 #include <gtest/gtest.h>
 
+#include <random>
+
 using namespace path_extend;
 using namespace debruijn_graph;
 
@@ -679,6 +684,68 @@ TEST( PathExtend, BidirectionalPathSearch ) {
 }
 
 
+TEST( PathExtend, BidirectionalPathLongSearch ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+    EdgeId start = *g.ConstEdgeBegin();
+
+    EdgeId e1 = g.conjugate(start);
+    EdgeId e2 = *(g.OutgoingEdges(g.EdgeEnd(e1)).begin());
+    EdgeId e3 = *(g.OutgoingEdges(g.EdgeEnd(e2)).begin());
+    EdgeId e4 = *(g.OutgoingEdges(g.EdgeEnd(e3)).begin());
+    EdgeId e5 = *(g.OutgoingEdges(g.EdgeEnd(e4)).begin());
+    EdgeId e6 = *(++g.OutgoingEdges(g.EdgeEnd(e5)).begin());
+
+    auto p = BidirectionalPath::create(g);
+    auto cp = BidirectionalPath::create(g);
+    cp->Subscribe(*p);
+    p->Subscribe(*cp);
+
+    // Long enough for the edge index to be used, conjugate path is extended from the front
+    p->PushBack(e1);
+    p->PushBack(e2, Gap(100));
+    p->PushBack(e3);
+    p->PushBack(e4);
+    for (size_t i = 0; i < 100; ++i) {
+        p->PushBack(e5, Gap(10));
+        p->PushBack(e6);
+    }
+    ASSERT_EQ(p->Size(), 204);
+
+    BidirectionalPath c = cp->Conjugate();
+    EXPECT_EQ(c, *p);
+    EXPECT_EQ(cp->Length(), p->Length());
+    for (size_t i = 0; i < p->Size(); ++i)
+        EXPECT_EQ(p->LengthAt(i), c.LengthAt(i));
+
+    EXPECT_EQ(p->FindFirst(e5), 4);
+    EXPECT_EQ(p->FindLast(e6), 203);
+    EXPECT_EQ(p->FindFirst(start), -1);
+    EXPECT_EQ(cp->FindFirst(g.conjugate(e6)), 0);
+    EXPECT_EQ(cp->FindLast(g.conjugate(e1)), 203);
+    EXPECT_EQ(cp->FindAll(g.conjugate(e5)).size(), 100);
+    EXPECT_TRUE(cp->Contains(g.conjugate(e2)));
+
+    auto v = p->FindAll(e6, 200);
+    ASSERT_EQ(v.size(), 2);
+    EXPECT_EQ(v[0], 201);
+    EXPECT_EQ(v[1], 203);
+
+    p->PopBack(150);
+    EXPECT_EQ(cp->Conjugate(), *p);
+    EXPECT_EQ(cp->Size(), 54);
+    EXPECT_EQ(cp->FindFirst(g.conjugate(e5)), 1);
+    EXPECT_EQ(cp->FindAll(g.conjugate(e5)).size(), 25);
+    EXPECT_EQ(cp->FindLast(g.conjugate(e2)), 52);
+    EXPECT_EQ(cp->LengthAt(0), p->Length());
+    EXPECT_EQ(p->FindLast(e6), 53);
+
+    p->Clear();
+    EXPECT_TRUE(cp->Empty());
+    EXPECT_EQ(cp->FindFirst(g.conjugate(e1)), -1);
+}
+
+
 TEST( PathExtend, BidirectionalPathLoopDetector ) {
     Graph g(13);
     ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
@@ -755,3 +822,102 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+TEST( PathExtend, BinnedHistogramWindows ) {
+    BinnedHistogram hist;
+    hist.Add(100, 0, 1.);
+    hist.Add(105, 0, 2.);
+    hist.Add(110, 20, 4.);
+    hist.Add(150, 5, 8.);
+    hist.Finalize();
+
+    EXPECT_DOUBLE_EQ(hist.Sum(100, 110), 7.);
+    EXPECT_DOUBLE_EQ(hist.Sum(101, 149), 6.);
+    EXPECT_DOUBLE_EQ(hist.Sum(151, 200), 0.);
+
+    // Every point is matched within its own deviation, so the wide one at 110 is hit from afar
+    EXPECT_DOUBLE_EQ(hist.Count(100), 5.);
+    EXPECT_DOUBLE_EQ(hist.Count(125), 4.);
+    EXPECT_DOUBLE_EQ(hist.Count(130), 4.);
+    EXPECT_DOUBLE_EQ(hist.Count(131), 0.);
+    EXPECT_DOUBLE_EQ(hist.Count(145), 8.);
+    EXPECT_DOUBLE_EQ(hist.Count(105, 0, 0), 6.);
+    EXPECT_DOUBLE_EQ(hist.Count(95, 0, 10), 7.);
+    EXPECT_DOUBLE_EQ(hist.Count(160, 10, 0), 8.);
+    EXPECT_TRUE(BinnedHistogram().empty());
+    EXPECT_DOUBLE_EQ(BinnedHistogram().Count(0, 100, 100), 0.);
+}
+
+// Plain non-additive IdealReads(), the closed form of IdealPairInfoCounter must match its expectation
+static double ExplicitIdealReads(int len1, int len2, int dist, int is, int k, int rs) {
+    if (dist == 0)
+        return len1 - is + 2 * rs - 2 - k + 1;
+    if (dist < 0) {
+        std::swap(len1, len2);
+        dist = -dist;
+    }
+
+    int gap_len = dist - len1;
+    int right = std::min(is - rs - 1, gap_len + len2 - 1);
+    int left = std::max(gap_len + k + 1 - rs, is - rs - len1 - rs + (k + 1));
+    return std::max(right - left + 1, 0);
+}
+
+TEST( PathExtend, IdealPairedInfoMatchesSummation ) {
+    Graph g(13);
+    const int k = (int) g.k();
+    std::mt19937 rnd(239);
+
+    for (size_t round = 0; round < 20; ++round) {
+        // Sparse distributions leave gaps between the insert sizes
+        std::map<int, size_t> distribution;
+        int is_center = std::uniform_int_distribution<int>(200, 600)(rnd);
+        int step = round % 2 ? 1 : std::uniform_int_distribution<int>(2, 15)(rnd);
+        for (int is = is_center - 150; is <= is_center + 150; is += step)
+            distribution[is] = std::uniform_int_distribution<size_t>(0, 100)(rnd);
+        int d_min = is_center - std::uniform_int_distribution<int>(0, 200)(rnd);
+        int d_max = is_center + std::uniform_int_distribution<int>(0, 200)(rnd);
+        int rs = std::uniform_int_distribution<int>(k + 2, 150)(rnd);
+        IdealPairInfoCounter counter(g, d_min, d_max, rs, distribution);
+
+        double total = 0;
+        for (const auto &entry : distribution)
+            total += double(entry.second);
+
+        for (size_t query = 0; query < 200; ++query) {
+            int len1 = std::uniform_int_distribution<int>(1, 1000)(rnd);
+            int len2 = std::uniform_int_distribution<int>(1, 1000)(rnd);
+            int dist = query % 10 == 0 ? 0 : std::uniform_int_distribution<int>(-1500, 1500)(rnd);
+
+            double expected = 0;
+            for (const auto &entry : distribution) {
+                if (entry.first < std::max(d_min, 0) || entry.first > d_max || !entry.second)
+                    continue;
+                expected += double(entry.second) / total * ExplicitIdealReads(len1, len2, dist, entry.first, k, rs);
+            }
+
+            EXPECT_NEAR(counter.IdealPairedInfo(size_t(len1), size_t(len2), dist), expected, 1e-9 * std::max(1., std::abs(expected)))
+                << "len1 " << len1 << " len2 " << len2 << " dist " << dist << " rs " << rs;
+        }
+    }
+}
+
+TEST( PathExtend, SeedContainerSortByLength ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+
+    std::vector<EdgeId> edges(g.canonical_edges().begin(), g.canonical_edges().end());
+    SeedContainer seeds(edges);
+    ASSERT_EQ(seeds.size(), edges.size());
+
+    PathContainer paths = seeds.ToPaths(g);
+    seeds.SortByLength(g);
+    paths.SortByLength();
+
+    ASSERT_EQ(paths.size(), seeds.size());
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        EXPECT_EQ(paths.Get(i).Size(), 1);
+        EXPECT_EQ(paths.Get(i).Front(), seeds[i]);
+        EXPECT_EQ(paths.GetConjugate(i).Front(), g.conjugate(seeds[i]));
+    }
+}
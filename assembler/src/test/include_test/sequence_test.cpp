@@ -42,3 +42,32 @@ TEST( Sequence, ReverseComplement ) {
     Sequence s2 = Sequence("ACG");
     EXPECT_EQ("CGT", (!s2).str());
 }
+
+TEST( Sequence, ArenaCopy ) {
+    NuclArena arena(128);
+    std::string str = "ACGTTGCAACGTACCGGTATATGCGCAATTCCGGAACGTTGCAACGTACCGGTATATGCGC";
+    Sequence s(str);
+    for (size_t from = 0; from < 40; from += 3) {
+        for (size_t to = from; to <= s.size(); to += 7) {
+            Sequence sub = s.Subseq(from, to);
+            Sequence copy(sub, arena);
+            EXPECT_EQ(sub, copy);
+            EXPECT_EQ(sub.str(), copy.str());
+
+            Sequence rc_copy(!sub, arena);
+            EXPECT_EQ(!sub, rc_copy);
+            EXPECT_EQ(sub, !rc_copy);
+        }
+    }
+    EXPECT_LT(1, arena.slabs());
+}
+
+TEST( Sequence, ArenaOutlived ) {
+    Sequence copy;
+    {
+        NuclArena arena;
+        copy = Sequence(Sequence("ACGTTGCAACGTACCGGTATATGCGC").Subseq(5, 20), arena);
+    }
+    EXPECT_EQ("GCAACGTACCGGTAT", copy.str());
+    EXPECT_EQ("ATACCGGTACGTTGC", (!copy).str());
+}